@@ -0,0 +1,198 @@
+#include "ByValue.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Basic/SourceManager.h>
+
+// LLVM includes
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "LayoutDefinitions.h"
+#include "Report.h"
+
+namespace ByValue
+{
+    struct Entry
+    {
+        const clang::FunctionDecl* function;
+        std::string                what;
+        clang::QualType            type;
+        Layout::TAmount            size;
+        unsigned int               calls;
+        bool                       hasNonTrivialCopy;
+    };
+
+    using TEntries         = std::vector<Entry>;
+    using TCallCount       = llvm::DenseMap<const clang::FunctionDecl*, unsigned int>;
+    using TFunctions       = std::vector<const clang::FunctionDecl*>;
+    using TFunctionIndices = llvm::DenseMap<const clang::FunctionDecl*, unsigned int>;
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    class FunctionVisitor : public clang::RecursiveASTVisitor<FunctionVisitor>
+    {
+    public:
+        FunctionVisitor(const clang::SourceManager& sourceManager, TFunctions& functions, TCallCount& calls)
+            : m_sourceManager(sourceManager)
+            , m_functions(functions)
+            , m_calls(calls)
+        {}
+
+        bool shouldVisitTemplateInstantiations() const { return true; }
+
+        bool VisitFunctionDecl(clang::FunctionDecl* declaration)
+        {
+            //out of line definitions count even when the function was first declared in a header
+            if (declaration->isImplicit() || declaration->isDependentContext() || !m_sourceManager.isInMainFile(declaration->getLocation()))
+            {
+                return true;
+            }
+
+            //one entry per function no matter how many times it is redeclared, keeping the definition if there is one
+            const clang::FunctionDecl* canonical = declaration->getCanonicalDecl();
+            const TFunctionIndices::const_iterator found = m_indices.find(canonical);
+            if (found == m_indices.end())
+            {
+                m_indices[canonical] = static_cast<unsigned int>(m_functions.size());
+                m_functions.push_back(declaration);
+            }
+            else if (declaration->isThisDeclarationADefinition())
+            {
+                m_functions[found->second] = declaration;
+            }
+            return true;
+        }
+
+        bool VisitCallExpr(clang::CallExpr* expression)
+        {
+            if (const clang::FunctionDecl* callee = expression->getDirectCallee())
+            {
+                ++m_calls[callee->getFirstDecl()];
+            }
+            return true;
+        }
+
+        bool VisitCXXConstructExpr(clang::CXXConstructExpr* expression)
+        {
+            //constructor calls are not CallExprs, temporary objects and brace initializations included
+            if (const clang::CXXConstructorDecl* constructor = expression->getConstructor())
+            {
+                ++m_calls[constructor->getFirstDecl()];
+            }
+            return true;
+        }
+
+    private:
+        const clang::SourceManager& m_sourceManager;
+        TFunctions&                 m_functions;
+        TCallCount&                 m_calls;
+        TFunctionIndices            m_indices;
+    };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        const clang::CXXRecordDecl* GetByValueRecord(const clang::QualType& type)
+        {
+            if (type.isNull() || type->isDependentType() || type->isReferenceType() || type->isPointerType())
+            {
+                return nullptr;
+            }
+
+            const clang::CXXRecordDecl* declaration = type->getAsCXXRecordDecl();
+            return declaration && declaration->hasDefinition() && !declaration->isInvalidDecl() ? declaration->getDefinition() : nullptr;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void TryAddEntry(TEntries& output, const clang::ASTContext& context, const clang::FunctionDecl* function, const std::string& what, const clang::QualType& type, const unsigned int calls)
+        {
+            if (const clang::CXXRecordDecl* declaration = GetByValueRecord(type))
+            {
+                const Layout::TAmount size = context.getTypeSizeInChars(type).getQuantity();
+                output.push_back(Entry{ function, what, type, size, calls, declaration->hasNonTrivialCopyConstructor() });
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void CollectEntries(TEntries& output, const clang::ASTContext& context)
+    {
+        TFunctions functions;
+        TCallCount calls;
+
+        FunctionVisitor visitor(context.getSourceManager(), functions, calls);
+        visitor.TraverseDecl(context.getTranslationUnitDecl());
+
+        for (const clang::FunctionDecl* function : functions)
+        {
+            //calls are keyed on the first declaration, the entry may be a later redeclaration
+            const TCallCount::const_iterator found = calls.find(function->getFirstDecl());
+            const unsigned int callCount = found != calls.end() ? found->second : 0u;
+
+            Helpers::TryAddEntry(output, context, function, "return", function->getReturnType(), callCount);
+
+            for (const clang::ParmVarDecl* parameter : function->parameters())
+            {
+                Helpers::TryAddEntry(output, context, function, "param " + (parameter->getName().empty() ? std::string("(unnamed)") : parameter->getNameAsString()), parameter->getType(), callCount);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const clang::ASTContext& context, llvm::raw_ostream& out, const Params& params)
+    {
+        const clang::SourceManager& sourceManager = context.getSourceManager();
+        out << "\n== By value records: " << sourceManager.getFilename(sourceManager.getLocForStartOfFile(sourceManager.getMainFileID())) << " (threshold " << params.threshold << " bytes) ==\n";
+
+        TEntries entries;
+        CollectEntries(entries, context);
+
+        if (entries.empty())
+        {
+            out << "  No records passed or returned by value found.\n";
+            return;
+        }
+
+        //most expensive first: bytes copied for all the call sites seen in this translation unit
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+        {
+            const Layout::TAmount costA = a.size * a.calls;
+            const Layout::TAmount costB = b.size * b.calls;
+            return costA != costB ? costA > costB : a.size > b.size;
+        });
+
+        unsigned int flagged = 0u;
+        out << "  " << llvm::left_justify("function", 48) << llvm::left_justify("passes", 24) << llvm::left_justify("type", 40) << "    size   calls\n";
+        for (const Entry& entry : entries)
+        {
+            const bool isLarge = entry.size > static_cast<Layout::TAmount>(params.threshold);
+            flagged += isLarge ? 1u : 0u;
+
+            out << "  " << llvm::left_justify(entry.function->getQualifiedNameAsString(), 48) << llvm::left_justify(entry.what, 24) << llvm::left_justify(Report::GetTypeName(context, entry.type), 40) << llvm::format_decimal(entry.size, 8) << llvm::format_decimal(entry.calls, 8);
+            if (isLarge)
+            {
+                out << "  [LARGE]";
+            }
+            if (entry.hasNonTrivialCopy)
+            {
+                out << "  [non trivial copy]";
+            }
+            out << "  " << Report::GetLocationString(context, entry.function->getLocation()) << "\n";
+        }
+
+        out << "  " << flagged << " of " << entries.size() << " by value records above " << params.threshold << " bytes\n";
+    }
+}
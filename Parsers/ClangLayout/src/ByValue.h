@@ -0,0 +1,21 @@
+#pragma once
+
+namespace clang
+{
+    class ASTContext;
+}
+
+namespace llvm
+{
+    class raw_ostream;
+}
+
+namespace ByValue
+{
+    struct Params
+    {
+        unsigned int threshold = 64u;
+    };
+
+    void Analyze(const clang::ASTContext& context, llvm::raw_ostream& out, const Params& params);
+}
@@ -0,0 +1,285 @@
+#include "Coalescing.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/Basic/TargetInfo.h>
+
+// LLVM includes
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "Report.h"
+
+namespace Coalescing
+{
+    struct Candidate
+    {
+        size_t          memberIndex;
+        Layout::TAmount bits;
+        const char*     kind;
+    };
+
+    using TCandidates = std::vector<Candidate>;
+
+    struct Range
+    {
+        std::string field;
+        long long   min;
+        long long   max;
+    };
+
+    using TRanges = std::vector<Range>;
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        const char* GetExclusionReason(const clang::FieldDecl* field, const Params& params)
+        {
+            const clang::QualType type = field->getType();
+
+            if (Report::IsAtomic(type))
+            {
+                return "atomic";
+            }
+
+            if (type.isVolatileQualified())
+            {
+                return "volatile";
+            }
+
+            if (std::find(params.excluded.begin(), params.excluded.end(), field->getNameAsString()) != params.excluded.end())
+            {
+                return "written from multiple threads";
+            }
+
+            return nullptr;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount GetStorageBytes(const Layout::TAmount bits)
+        {
+            return bits <= 8 ? 1 : bits <= 16 ? 2 : bits <= 32 ? 4 : Report::AlignTo(bits, 64) / 8;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        const char* GetStorageTypeName(const Layout::TAmount bytes)
+        {
+            return bytes == 1 ? "uint8_t" : bytes == 2 ? "uint16_t" : bytes == 4 ? "uint32_t" : "uint64_t";
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool ParseNumber(long long& output, const std::string& text)
+        {
+            char* end = nullptr;
+            output = std::strtoll(text.c_str(), &end, 10);
+            return !text.empty() && end && *end == '\0';
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void ParseRanges(TRanges& output, const Report::Context& context, const Params& params)
+        {
+            for (const std::string& text : params.ranges)
+            {
+                const size_t first  = text.find(':');
+                const size_t second = first == std::string::npos ? std::string::npos : text.find(':', first + 1);
+
+                Range range;
+                if (first == 0 || second == std::string::npos || !ParseNumber(range.min, text.substr(first + 1, second - first - 1)) || !ParseNumber(range.max, text.substr(second + 1)) || range.min > range.max)
+                {
+                    context.out << "  ignored range '" << text << "' (expected field:min:max)\n";
+                    continue;
+                }
+
+                range.field = text.substr(0, first);
+                output.push_back(range);
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount CountBits(unsigned long long value)
+        {
+            Layout::TAmount bits = 0;
+            for (; value; value >>= 1)
+            {
+                ++bits;
+            }
+            return bits;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount GetRangeBits(const Range& range)
+        {
+            //unsigned storage for non negative ranges, two's complement otherwise
+            if (range.min >= 0)
+            {
+                return std::max<Layout::TAmount>(CountBits(static_cast<unsigned long long>(range.max)), 1);
+            }
+
+            const Layout::TAmount negativeBits = CountBits(~static_cast<unsigned long long>(range.min));
+            const Layout::TAmount positiveBits = range.max > 0 ? CountBits(static_cast<unsigned long long>(range.max)) : 0;
+            return std::max(negativeBits, positiveBits) + 1;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount GetEnumBits(const clang::ASTContext& context, const clang::EnumDecl* declaration)
+        {
+            bool isSigned = false;
+            Layout::TAmount bits = Report::GetRequiredBits(declaration, isSigned);
+
+            //MSVC sign extends enum bitfields when the underlying type is signed, keep a spare bit for the sign
+            if (!isSigned && context.getTargetInfo().getCXXABI().isMicrosoft() && declaration->getIntegerType()->isSignedIntegerType())
+            {
+                ++bits;
+            }
+
+            return bits;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void CollectCandidates(TCandidates& output, const Report::Context& context, const Report::Shape& shape, const TRanges& ranges, const Params& params)
+    {
+        for (size_t i = 0; i < shape.members.size(); ++i)
+        {
+            const Report::Member& member = shape.members[i];
+            const clang::FieldDecl* field = member.field;
+            const clang::QualType type = field->getType();
+
+            if (member.size == 0)
+            {
+                continue;
+            }
+
+            Candidate candidate{ i, 0, nullptr };
+            if (field->isBitField())
+            {
+                if (member.bits < member.size * 8)
+                {
+                    candidate.kind = "bitfield";
+                    candidate.bits = member.bits;
+                }
+            }
+            else if (type->isBooleanType())
+            {
+                candidate.kind = "bool";
+                candidate.bits = 1;
+            }
+            else if (const clang::EnumType* enumType = type->getAs<clang::EnumType>())
+            {
+                const clang::EnumDecl* enumDeclaration = enumType->getDecl()->getDefinition();
+                if (enumDeclaration)
+                {
+                    candidate.kind = "enum";
+                    candidate.bits = Helpers::GetEnumBits(context.ast, enumDeclaration);
+                }
+            }
+            else if (type->isIntegerType())
+            {
+                //plain integers only get a smaller range when the user states it
+                const std::string fieldName = field->getNameAsString();
+                const TRanges::const_iterator range = std::find_if(ranges.begin(), ranges.end(), [&fieldName](const Range& entry) { return entry.field == fieldName; });
+                if (range != ranges.end())
+                {
+                    candidate.kind = "integer";
+                    candidate.bits = Helpers::GetRangeBits(*range);
+                }
+            }
+            else if (Report::IsAtomic(type) && member.size == 1)
+            {
+                //atomic flags are only listed to show they are kept apart
+                candidate.kind = "atomic";
+            }
+
+            if (!candidate.kind || candidate.bits >= member.bits)
+            {
+                continue;
+            }
+
+            if (const char* reason = Helpers::GetExclusionReason(field, params))
+            {
+                context.out << "  kept apart: " << field->getName() << " (" << reason << ")\n";
+                continue;
+            }
+
+            output.push_back(candidate);
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context, const Params& params)
+    {
+        Report::WriteTitle(context, "Bitfield coalescing");
+
+        Report::Shape shape;
+        Report::ComputeShape(shape, context.ast, context.declaration);
+
+        TRanges ranges;
+        Helpers::ParseRanges(ranges, context, params);
+
+        TCandidates candidates;
+        CollectCandidates(candidates, context, shape, ranges, params);
+
+        if (candidates.size() < 2)
+        {
+            context.out << "  No coalescing candidates found.\n";
+            return;
+        }
+
+        Layout::TAmount totalBits  = 0;
+        Layout::TAmount storeAlign = 1;
+        std::vector<bool> isCandidate(shape.members.size(), false);
+
+        context.out << "  Candidates:\n";
+        for (const Candidate& candidate : candidates)
+        {
+            const Report::Member& member = shape.members[candidate.memberIndex];
+            context.out << "    " << llvm::left_justify(candidate.kind, 10) << llvm::left_justify(member.field->getName(), 32) << llvm::format_decimal(candidate.bits, 3) << " bits in " << member.size << " bytes\n";
+
+            totalBits += candidate.bits;
+            storeAlign = std::max(storeAlign, member.align);
+            isCandidate[candidate.memberIndex] = true;
+        }
+
+        //replace all candidates with the shared storage at the position of the first one
+        const Layout::TAmount storageBytes = Helpers::GetStorageBytes(totalBits);
+
+        Report::Shape coalesced = shape;
+        coalesced.members.clear();
+
+        bool inserted = false;
+        for (size_t i = 0; i < shape.members.size(); ++i)
+        {
+            if (!isCandidate[i])
+            {
+                coalesced.members.push_back(shape.members[i]);
+            }
+            else if (!inserted)
+            {
+                for (Layout::TAmount remaining = storageBytes; remaining > 0; remaining -= 8)
+                {
+                    const Layout::TAmount unitSize = std::min<Layout::TAmount>(remaining, 8);
+                    coalesced.members.push_back(Report::Member{ shape.members[i].field, unitSize, std::min(unitSize, storeAlign), unitSize * 8 });
+                }
+                inserted = true;
+            }
+        }
+
+        const Layout::TAmount currentSize   = Report::ComputeSize(shape);
+        const Layout::TAmount inPlaceSize   = Report::ComputeSize(coalesced);
+        const Layout::TAmount reorderedSize = Report::ComputeSortedSize(coalesced);
+
+        context.out << "  " << totalBits << " bits fit in " << storageBytes << " bytes of " << Helpers::GetStorageTypeName(storageBytes) << " bitfields\n";
+        context.out << "  Estimated size: " << currentSize << " bytes\n";
+        context.out << "    coalesced in place:   " << inPlaceSize << " bytes (" << (currentSize - inPlaceSize) << " bytes saved per instance)\n";
+        context.out << "    coalesced + reorder:  " << reorderedSize << " bytes (" << (currentSize - reorderedSize) << " bytes saved per instance)\n";
+        context.out << "  Note: coalesced fields become one memory location, concurrent writes to different fields will race.\n";
+    }
+}
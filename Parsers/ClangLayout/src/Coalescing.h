@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Report
+{
+    struct Context;
+}
+
+namespace Coalescing
+{
+    struct Params
+    {
+        std::vector<std::string> excluded;   //fields written from multiple threads that must keep their own memory location
+        std::vector<std::string> ranges;     //"field:min:max" value ranges of integer fields, they become candidates when the range needs fewer bits
+    };
+
+    void Analyze(const Report::Context& context, const Params& params);
+}
@@ -0,0 +1,134 @@
+#include "EmptyMembers.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/RecordLayout.h>
+#include <clang/Basic/TargetInfo.h>
+
+// LLVM includes
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <set>
+
+#include "Report.h"
+
+namespace EmptyMembers
+{
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        const clang::CXXRecordDecl* GetEmptyRecord(const clang::FieldDecl* field)
+        {
+            //arrays of empty types still take one byte per element
+            const clang::CXXRecordDecl* declaration = field->getType()->getAsCXXRecordDecl();
+            return declaration && declaration->hasDefinition() && declaration->isEmpty() ? declaration : nullptr;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void ReportEmptyFields(const Report::Context& context)
+    {
+        const clang::ASTRecordLayout& layout = context.ast.getASTRecordLayout(context.declaration);
+        const bool isMicrosoft = context.ast.getTargetInfo().getCXXABI().isMicrosoft();
+
+        Report::Shape shape;
+        Report::ComputeShape(shape, context.ast, context.declaration);
+
+        Report::Shape collapsed = shape;
+        collapsed.members.clear();
+
+        std::set<const clang::CXXRecordDecl*> seenTypes;
+        bool hasRepeatedTypes = false;
+        unsigned int found = 0u;
+
+        for (const Report::Member& member : shape.members)
+        {
+            const clang::CXXRecordDecl* emptyRecord = member.field->isBitField() ? nullptr : Helpers::GetEmptyRecord(member.field);
+
+            //zero sized members are already [[no_unique_address]]
+            if (!emptyRecord || member.size == 0)
+            {
+                collapsed.members.push_back(member);
+                continue;
+            }
+
+            if (found++ == 0u)
+            {
+                context.out << "  Empty member fields:\n";
+            }
+
+            const Layout::TAmount offset = context.ast.toCharUnitsFromBits(layout.getFieldOffset(member.field->getFieldIndex())).getQuantity();
+            context.out << "    " << llvm::left_justify(member.field->getName(), 32) << llvm::left_justify(Report::GetTypeName(context.ast, member.field->getType()), 40) << "offset " << llvm::format_decimal(offset, 5) << "  size " << member.size << "\n";
+
+            hasRepeatedTypes |= !seenTypes.insert(emptyRecord->getCanonicalDecl()).second;
+        }
+
+        if (found == 0u)
+        {
+            context.out << "  No empty member fields found.\n";
+            return;
+        }
+
+        const Layout::TAmount currentSize   = Report::ComputeSize(shape);
+        const Layout::TAmount inPlaceSize   = Report::ComputeSize(collapsed);
+        const Layout::TAmount reorderedSize = Report::ComputeSortedSize(collapsed);
+
+        context.out << "  Estimated size: " << currentSize << " bytes\n";
+        context.out << "    as empty bases or no_unique_address:           " << inPlaceSize << " bytes (" << (currentSize - inPlaceSize) << " bytes reclaimed per instance)\n";
+        context.out << "    as empty bases or no_unique_address + reorder: " << reorderedSize << " bytes (" << (currentSize - reorderedSize) << " bytes reclaimed per instance)\n";
+
+        if (hasRepeatedTypes)
+        {
+            context.out << "  Note: empty members of the same type need distinct addresses, only one of them can overlap another member.\n";
+        }
+
+        if (isMicrosoft)
+        {
+            context.out << "  Note: the Microsoft ABI ignores [[no_unique_address]], use [[msvc::no_unique_address]] or empty bases instead.\n";
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void ReportBlockedTailPadding(const Report::Context& context)
+    {
+        //the Itanium ABI reuses the tail padding of non POD bases only, the Microsoft ABI never does
+        if (context.ast.getTargetInfo().getCXXABI().isMicrosoft() || context.declaration->fields().empty())
+        {
+            return;
+        }
+
+        for (const clang::CXXBaseSpecifier& base : context.declaration->bases())
+        {
+            const clang::CXXRecordDecl* baseDeclaration = base.getType()->getAsCXXRecordDecl();
+            if (base.isVirtual() || baseDeclaration->isEmpty() || !baseDeclaration->isPOD())
+            {
+                continue;
+            }
+
+            const Layout::TAmount baseSize  = context.ast.getASTRecordLayout(baseDeclaration).getNonVirtualSize().getQuantity();
+            const Layout::TAmount dataEnd   = Report::GetDataEnd(context.ast, baseDeclaration);
+            const Layout::TAmount tailBytes = baseSize - dataEnd;
+            if (tailBytes > 0)
+            {
+                context.out << "  Base " << baseDeclaration->getQualifiedNameAsString() << " is POD, its " << tailBytes << " bytes of tail padding cannot be reused by the fields of " << context.declaration->getName() << "\n";
+                context.out << "    (a user declared constructor or a non public member in the base would allow the reuse)\n";
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context)
+    {
+        Report::WriteTitle(context, "Empty members");
+
+        ReportEmptyFields(context);
+        ReportBlockedTailPadding(context);
+    }
+}
@@ -0,0 +1,111 @@
+#include "EnumNarrowing.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+
+// LLVM includes
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+
+#include "Report.h"
+
+namespace EnumNarrowing
+{
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount GetMinimalBytes(const unsigned int bits)
+        {
+            return bits <= 8 ? 1 : bits <= 16 ? 2 : bits <= 32 ? 4 : 8;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        const char* GetIntegerTypeName(const Layout::TAmount bytes, const bool isSigned)
+        {
+            switch (bytes)
+            {
+            case 1:  return isSigned ? "int8_t"  : "uint8_t";
+            case 2:  return isSigned ? "int16_t" : "uint16_t";
+            case 4:  return isSigned ? "int32_t" : "uint32_t";
+            default: return isSigned ? "int64_t" : "uint64_t";
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context)
+    {
+        Report::WriteTitle(context, "Enum narrowing");
+
+        Report::Shape shape;
+        Report::ComputeShape(shape, context.ast, context.declaration);
+
+        Report::Shape narrowed = shape;
+        unsigned int numNarrowed = 0u;
+
+        for (Report::Member& member : narrowed.members)
+        {
+            const clang::FieldDecl* field = member.field;
+            if (field->isBitField() || member.size == 0)
+            {
+                continue;
+            }
+
+            //plain enums and arrays of enums
+            const clang::QualType elementType = context.ast.getBaseElementType(field->getType());
+            const clang::EnumType* enumType = elementType->getAs<clang::EnumType>();
+            const clang::EnumDecl* enumDeclaration = enumType ? enumType->getDecl()->getDefinition() : nullptr;
+            if (!enumDeclaration || enumDeclaration->getIntegerType().isNull())
+            {
+                continue;
+            }
+
+            const Layout::TAmount elementSize = context.ast.getTypeSizeInChars(elementType).getQuantity();
+            const Layout::TAmount count       = elementSize ? member.size / elementSize : 0;
+
+            bool isSigned = false;
+            const unsigned int bits = Report::GetRequiredBits(enumDeclaration, isSigned);
+            const Layout::TAmount minimalSize = Helpers::GetMinimalBytes(bits);
+
+            context.out << "  " << llvm::left_justify(field->getName(), 24) << llvm::left_justify(enumDeclaration->getQualifiedNameAsString(), 32)
+                        << Report::GetTypeName(context.ast, enumDeclaration->getIntegerType()) << (enumDeclaration->isFixed() ? " (fixed)" : "")
+                        << " -> " << Helpers::GetIntegerTypeName(minimalSize, isSigned) << " (" << bits << " bits used)";
+
+            if (minimalSize < elementSize)
+            {
+                context.out << ", " << (elementSize - minimalSize) * count << " bytes smaller\n";
+
+                member.size  = minimalSize * count;
+                member.align = std::min(member.align, minimalSize);
+                ++numNarrowed;
+            }
+            else
+            {
+                context.out << ", already minimal\n";
+            }
+        }
+
+        if (numNarrowed == 0)
+        {
+            context.out << "  No enum fields can be narrowed.\n";
+            return;
+        }
+
+        //narrowing alone often lands in existing padding, the reorder it enables is what shrinks the record
+        const Layout::TAmount currentSize        = Report::ComputeSize(shape);
+        const Layout::TAmount currentSortedSize  = Report::ComputeSortedSize(shape);
+        const Layout::TAmount narrowedSize       = Report::ComputeSize(narrowed);
+        const Layout::TAmount narrowedSortedSize = Report::ComputeSortedSize(narrowed);
+
+        context.out << "  Estimated size: " << currentSize << " bytes (" << currentSortedSize << " bytes reordered without narrowing)\n";
+        context.out << "    narrowed in place:    " << narrowedSize << " bytes (" << (currentSize - narrowedSize) << " bytes saved per instance)\n";
+        context.out << "    narrowed + reorder:   " << narrowedSortedSize << " bytes (" << (currentSize - narrowedSortedSize) << " bytes saved per instance)\n";
+    }
+}
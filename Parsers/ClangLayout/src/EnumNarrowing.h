@@ -0,0 +1,11 @@
+#pragma once
+
+namespace Report
+{
+    struct Context;
+}
+
+namespace EnumNarrowing
+{
+    void Analyze(const Report::Context& context);
+}
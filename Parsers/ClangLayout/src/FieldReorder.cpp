@@ -0,0 +1,665 @@
+#include "FieldReorder.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Lex/Lexer.h>
+#include <clang/Rewrite/Core/Rewriter.h>
+
+// LLVM includes
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "IO.h"
+
+namespace FieldReorder
+{
+    // A member declaration together with its leading comments, attributes and trailing comment
+    struct FieldSlot
+    {
+        const clang::FieldDecl* field;
+        unsigned int            begin;
+        unsigned int            end;
+        unsigned int            rank;
+        bool                    movable;
+    };
+
+    using TSlots = std::vector<FieldSlot>;
+    using TLines = std::vector<llvm::StringRef>;
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        llvm::StringRef TrimLine(llvm::StringRef line)
+        {
+            return line.trim(" \t\r\n");
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsCommentLine(llvm::StringRef line)
+        {
+            line = TrimLine(line);
+            return line.starts_with("//") || line.starts_with("/*") || line.starts_with("*");
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool HasDirective(llvm::StringRef text)
+        {
+            while (!text.empty())
+            {
+                const std::pair<llvm::StringRef, llvm::StringRef> split = text.split('\n');
+                if (TrimLine(split.first).starts_with("#"))
+                {
+                    return true;
+                }
+                text = split.second;
+            }
+            return false;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        unsigned int FindLineStart(llvm::StringRef buffer, unsigned int offset)
+        {
+            while (offset > 0 && buffer[offset - 1] != '\n') --offset;
+            return offset;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void SplitLines(TLines& output, llvm::StringRef text)
+        {
+            while (!text.empty())
+            {
+                const size_t end = text.find('\n');
+                const size_t length = end == llvm::StringRef::npos ? text.size() : end + 1;
+                output.push_back(text.substr(0, length));
+                text = text.substr(length);
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        clang::SourceLocation GetBeginLocation(const clang::FieldDecl* field)
+        {
+            clang::SourceLocation ret = field->getBeginLoc();
+            for (const clang::Attr* attribute : field->attrs())
+            {
+                const clang::SourceLocation attributeLoc = attribute->getRange().getBegin();
+                if (attributeLoc.isValid() && attributeLoc < ret)
+                {
+                    ret = attributeLoc;
+                }
+            }
+            return ret;
+        }
+    }
+
+    namespace Diff
+    {
+        struct Line
+        {
+            char            op;
+            llvm::StringRef text;
+        };
+
+        using TDiff = std::vector<Line>;
+
+        enum { CONTEXT_LINES = 3 };
+
+        // -----------------------------------------------------------------------------------------------------------
+        void Compute(TDiff& output, const TLines& before, const TLines& after)
+        {
+            //skip the common head and tail, reorders only touch a small window of the file
+            size_t prefix = 0;
+            while (prefix < before.size() && prefix < after.size() && before[prefix] == after[prefix]) ++prefix;
+
+            size_t suffix = 0;
+            while (suffix < before.size() - prefix && suffix < after.size() - prefix && before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) ++suffix;
+
+            const size_t n = before.size() - prefix - suffix;
+            const size_t m = after.size() - prefix - suffix;
+
+            //longest common subsequence table for the changed window
+            std::vector<unsigned int> lcs((n + 1) * (m + 1), 0u);
+            for (size_t i = n; i-- > 0;)
+            {
+                for (size_t j = m; j-- > 0;)
+                {
+                    lcs[i * (m + 1) + j] = before[prefix + i] == after[prefix + j] ? lcs[(i + 1) * (m + 1) + j + 1] + 1 : std::max(lcs[(i + 1) * (m + 1) + j], lcs[i * (m + 1) + j + 1]);
+                }
+            }
+
+            for (size_t i = 0; i < prefix; ++i)
+            {
+                output.push_back(Line{ ' ', before[i] });
+            }
+
+            size_t i = 0;
+            size_t j = 0;
+            while (i < n && j < m)
+            {
+                if (before[prefix + i] == after[prefix + j])
+                {
+                    output.push_back(Line{ ' ', before[prefix + i] });
+                    ++i;
+                    ++j;
+                }
+                else if (lcs[(i + 1) * (m + 1) + j] >= lcs[i * (m + 1) + j + 1])
+                {
+                    output.push_back(Line{ '-', before[prefix + i++] });
+                }
+                else
+                {
+                    output.push_back(Line{ '+', after[prefix + j++] });
+                }
+            }
+            for (; i < n; ++i) output.push_back(Line{ '-', before[prefix + i] });
+            for (; j < m; ++j) output.push_back(Line{ '+', after[prefix + j] });
+
+            for (size_t k = before.size() - suffix; k < before.size(); ++k)
+            {
+                output.push_back(Line{ ' ', before[k] });
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void WriteLine(llvm::raw_ostream& out, const Line& line)
+        {
+            out << line.op << line.text;
+            if (!line.text.ends_with("\n"))
+            {
+                out << "\n\\ No newline at end of file\n";
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void WriteUnified(llvm::raw_ostream& out, llvm::StringRef filename, llvm::StringRef before, llvm::StringRef after)
+        {
+            TLines beforeLines;
+            TLines afterLines;
+            Helpers::SplitLines(beforeLines, before);
+            Helpers::SplitLines(afterLines, after);
+
+            TDiff lines;
+            Compute(lines, beforeLines, afterLines);
+
+            out << "--- a/" << filename << "\n";
+            out << "+++ b/" << filename << "\n";
+
+            size_t index = 0;
+            size_t oldLine = 0;
+            size_t newLine = 0;
+            while (index < lines.size())
+            {
+                size_t change = index;
+                while (change < lines.size() && lines[change].op == ' ') ++change;
+                if (change == lines.size())
+                {
+                    break;
+                }
+
+                //merge the following changes while their context overlaps
+                size_t changeEnd = change;
+                size_t cursor = change;
+                while (cursor < lines.size())
+                {
+                    if (lines[cursor].op != ' ')
+                    {
+                        changeEnd = ++cursor;
+                        continue;
+                    }
+
+                    size_t next = cursor;
+                    while (next < lines.size() && lines[next].op == ' ') ++next;
+                    if (next == lines.size() || next - cursor > 2 * CONTEXT_LINES)
+                    {
+                        break;
+                    }
+                    cursor = next;
+                }
+
+                const size_t hunkBegin = std::max(index, change > CONTEXT_LINES ? change - CONTEXT_LINES : 0);
+                const size_t hunkEnd   = std::min(lines.size(), changeEnd + CONTEXT_LINES);
+
+                for (; index < hunkBegin; ++index)
+                {
+                    ++oldLine;
+                    ++newLine;
+                }
+
+                size_t oldCount = 0;
+                size_t newCount = 0;
+                for (size_t k = hunkBegin; k < hunkEnd; ++k)
+                {
+                    oldCount += lines[k].op != '+';
+                    newCount += lines[k].op != '-';
+                }
+
+                out << "@@ -" << (oldCount ? oldLine + 1 : oldLine) << "," << oldCount << " +" << (newCount ? newLine + 1 : newLine) << "," << newCount << " @@\n";
+                for (; index < hunkEnd; ++index)
+                {
+                    WriteLine(out, lines[index]);
+                    oldLine += lines[index].op != '+';
+                    newLine += lines[index].op != '-';
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void ComputeRanks(TSlots& slots, const clang::ASTContext& context, const Params& params)
+    {
+        if (params.fieldOrder.empty())
+        {
+            //natural alignment descending removes all the inter-field padding that does not come from bitfields
+            std::vector<size_t> order(slots.size());
+            for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+
+            std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) { return context.getDeclAlign(slots[a].field) > context.getDeclAlign(slots[b].field); });
+
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                slots[order[i]].rank = static_cast<unsigned int>(i);
+            }
+        }
+        else
+        {
+            const unsigned int listSize = static_cast<unsigned int>(params.fieldOrder.size());
+            for (unsigned int i = 0; i < slots.size(); ++i)
+            {
+                slots[i].rank = listSize + i;
+            }
+
+            for (unsigned int i = 0; i < listSize; ++i)
+            {
+                const std::string& name = params.fieldOrder[i];
+                auto found = std::find_if(slots.begin(), slots.end(), [&](const FieldSlot& slot) { return slot.field->getName() == name; });
+                if (found == slots.end())
+                {
+                    LOG_WARNING("Field '%s' from the requested order does not exist.", name.c_str());
+                    continue;
+                }
+                found->rank = i;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool CollectSlots(TSlots& slots, const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, clang::FileID& fileId)
+    {
+        const clang::SourceManager& sourceManager = context.getSourceManager();
+        const clang::LangOptions& langOptions = context.getLangOpts();
+
+        const clang::SourceLocation braceLoc = declaration->getBraceRange().getBegin();
+        if (braceLoc.isInvalid() || braceLoc.isMacroID())
+        {
+            LOG_ERROR("Unable to reorder '%s': the record body is not written in a source file.", declaration->getQualifiedNameAsString().c_str());
+            return false;
+        }
+
+        fileId = sourceManager.getFileID(braceLoc);
+        const llvm::StringRef buffer = sourceManager.getBufferData(fileId);
+        unsigned int limit = sourceManager.getFileOffset(braceLoc) + 1;
+
+        const clang::FieldDecl* previous = nullptr;
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            FieldSlot slot{ field, 0u, 0u, 0u, false };
+
+            const clang::SourceLocation beginLoc = Helpers::GetBeginLocation(field);
+            const clang::SourceLocation endLoc = field->getEndLoc();
+
+            //multiple declarators (int a, b;) share their type specifier and cannot be split
+            const bool sharedDeclaration = previous && previous->getBeginLoc() == field->getBeginLoc();
+            if (sharedDeclaration && !slots.empty())
+            {
+                slots.back().movable = false;
+            }
+            previous = field;
+
+            if (!sharedDeclaration && !field->isBitField() && beginLoc.isFileID() && endLoc.isFileID() && sourceManager.getFileID(beginLoc) == fileId)
+            {
+                const clang::SourceLocation afterSemi = clang::Lexer::findLocationAfterToken(endLoc, clang::tok::semi, sourceManager, langOptions, false);
+                const unsigned int beginOffset = sourceManager.getFileOffset(beginLoc);
+                const unsigned int lineStart = Helpers::FindLineStart(buffer, beginOffset);
+
+                if (afterSemi.isValid() && lineStart >= limit && Helpers::TrimLine(buffer.slice(lineStart, beginOffset)).empty())
+                {
+                    //the declaration needs to own the rest of its line (whitespace or a trailing comment)
+                    unsigned int end = sourceManager.getFileOffset(afterSemi);
+                    const size_t lineEnd = buffer.find('\n', end);
+                    const llvm::StringRef rest = Helpers::TrimLine(buffer.slice(end, lineEnd));
+
+                    if (rest.empty() || rest.starts_with("//"))
+                    {
+                        end = lineEnd == llvm::StringRef::npos ? static_cast<unsigned int>(buffer.size()) : static_cast<unsigned int>(lineEnd + 1);
+
+                        //take along the comment lines right above the declaration
+                        unsigned int begin = lineStart;
+                        while (begin > limit)
+                        {
+                            const unsigned int previousLine = Helpers::FindLineStart(buffer, begin - 1);
+                            if (previousLine < limit || !Helpers::IsCommentLine(buffer.slice(previousLine, begin)))
+                            {
+                                break;
+                            }
+                            begin = previousLine;
+                        }
+
+                        slot.begin   = begin;
+                        slot.end     = end;
+                        slot.movable = !Helpers::HasDirective(buffer.slice(begin, end));
+                    }
+                }
+            }
+
+            if (slot.movable)
+            {
+                limit = slot.end;
+            }
+            else
+            {
+                LOG_INFO("Field '%s' is kept in place.", field->getNameAsString().c_str());
+            }
+
+            slots.push_back(slot);
+        }
+
+        return !slots.empty();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void ReorderFields(std::vector<const clang::FieldDecl*>& newOrder, clang::Rewriter& rewriter, TSlots& slots, const clang::SourceManager& sourceManager, const clang::FileID fileId)
+    {
+        const llvm::StringRef buffer = sourceManager.getBufferData(fileId);
+
+        //group movable fields that share access and are not separated by preprocessor directives
+        size_t groupBegin = 0;
+        while (groupBegin < slots.size())
+        {
+            size_t groupEnd = groupBegin + 1;
+            if (slots[groupBegin].movable)
+            {
+                while (groupEnd < slots.size() &&
+                       slots[groupEnd].movable &&
+                       slots[groupEnd].field->getAccess() == slots[groupBegin].field->getAccess() &&
+                       !Helpers::HasDirective(buffer.slice(slots[groupEnd - 1].end, slots[groupEnd].begin)))
+                {
+                    ++groupEnd;
+                }
+            }
+
+            std::vector<FieldSlot> sorted(slots.begin() + groupBegin, slots.begin() + groupEnd);
+            std::stable_sort(sorted.begin(), sorted.end(), [](const FieldSlot& a, const FieldSlot& b) { return a.rank < b.rank; });
+
+            for (size_t i = groupBegin; i < groupEnd; ++i)
+            {
+                const FieldSlot& target = slots[i];
+                const FieldSlot& source = sorted[i - groupBegin];
+                newOrder.push_back(source.field);
+
+                if (target.field != source.field)
+                {
+                    rewriter.ReplaceText(sourceManager.getComposedLoc(fileId, target.begin), target.end - target.begin, buffer.slice(source.begin, source.end));
+                }
+            }
+
+            groupBegin = groupEnd;
+        }
+    }
+
+    using TFieldSet = std::unordered_set<const clang::FieldDecl*>;
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Collects the fields of the record an initializer reads through this, taking their address is not a read
+    class FieldReadVisitor : public clang::RecursiveASTVisitor<FieldReadVisitor>
+    {
+    public:
+        FieldReadVisitor(const clang::CXXRecordDecl* declaration, TFieldSet& fields)
+            : m_declaration(declaration)
+            , m_fields(fields)
+        {}
+
+        bool VisitUnaryOperator(clang::UnaryOperator* expression)
+        {
+            //parents are visited first, the member expression below is skipped when reached
+            if (expression->getOpcode() == clang::UO_AddrOf)
+            {
+                m_addressed.insert(expression->getSubExpr()->IgnoreParens());
+            }
+            return true;
+        }
+
+        bool VisitMemberExpr(clang::MemberExpr* expression)
+        {
+            const clang::FieldDecl* field = llvm::dyn_cast<clang::FieldDecl>(expression->getMemberDecl());
+            if (field && field->getParent() == m_declaration && llvm::isa<clang::CXXThisExpr>(expression->getBase()->IgnoreParenImpCasts()) && m_addressed.find(expression) == m_addressed.end())
+            {
+                m_fields.insert(field);
+            }
+            return true;
+        }
+
+    private:
+        const clang::CXXRecordDecl*            m_declaration;
+        TFieldSet&                             m_fields;
+        std::unordered_set<const clang::Expr*> m_addressed;
+    };
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool CheckReads(const clang::CXXRecordDecl* declaration, const clang::FieldDecl* field, const clang::Expr* initializer, const std::unordered_map<const clang::FieldDecl*, size_t>& newIndex, const std::string& where)
+    {
+        TFieldSet reads;
+        FieldReadVisitor visitor(declaration, reads);
+        visitor.TraverseStmt(const_cast<clang::Expr*>(initializer));
+
+        //only the reads the new order breaks, a field read before its initialization already was is left as is
+        bool ret = true;
+        for (const clang::FieldDecl* read : reads)
+        {
+            if (read->getFieldIndex() < field->getFieldIndex() && newIndex.at(read) > newIndex.at(field))
+            {
+                LOG_ERROR("Unable to reorder '%s': %s initializes '%s' from '%s', which would be initialized after it.", declaration->getQualifiedNameAsString().c_str(), where.c_str(),
+                    field->getNameAsString().c_str(), read->getNameAsString().c_str());
+                ret = false;
+            }
+        }
+        return ret;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool CheckInitializerDependencies(const clang::CXXRecordDecl* declaration, const std::vector<const clang::FieldDecl*>& newOrder, const clang::ASTContext& context)
+    {
+        const clang::SourceManager& sourceManager = context.getSourceManager();
+
+        std::unordered_map<const clang::FieldDecl*, size_t> newIndex;
+        for (size_t i = 0; i < newOrder.size(); ++i)
+        {
+            newIndex[newOrder[i]] = i;
+        }
+
+        bool ret = true;
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            if (const clang::Expr* initializer = field->getInClassInitializer())
+            {
+                ret = CheckReads(declaration, field, initializer, newIndex, "the in class initializer") && ret;
+            }
+        }
+
+        for (const clang::CXXConstructorDecl* constructor : declaration->ctors())
+        {
+            const clang::FunctionDecl* definition = nullptr;
+            if (constructor->isImplicit() || !constructor->hasBody(definition))
+            {
+                continue;
+            }
+
+            const clang::CXXConstructorDecl* constructorDefinition = llvm::cast<clang::CXXConstructorDecl>(definition);
+            const std::string where = "the constructor at " + constructorDefinition->getLocation().printToString(sourceManager);
+            for (const clang::CXXCtorInitializer* initializer : constructorDefinition->inits())
+            {
+                //the in class initializers were checked once above
+                if (initializer->isWritten() && initializer->isMemberInitializer() && initializer->getInit())
+                {
+                    ret = CheckReads(declaration, initializer->getMember(), initializer->getInit(), newIndex, where) && ret;
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    unsigned int ReorderInitializers(clang::Rewriter& rewriter, const clang::CXXRecordDecl* declaration, const std::vector<const clang::FieldDecl*>& newOrder, const clang::ASTContext& context)
+    {
+        const clang::SourceManager& sourceManager = context.getSourceManager();
+        const clang::LangOptions& langOptions = context.getLangOpts();
+
+        std::unordered_map<const clang::FieldDecl*, size_t> newIndex;
+        for (size_t i = 0; i < newOrder.size(); ++i)
+        {
+            newIndex[newOrder[i]] = i;
+        }
+
+        unsigned int numConstructors = 0u;
+        for (const clang::CXXConstructorDecl* constructor : declaration->ctors())
+        {
+            //the definition can live out of line in any file of the translation unit
+            const clang::FunctionDecl* definition = nullptr;
+            if (constructor->isImplicit() || !constructor->hasBody(definition))
+            {
+                continue;
+            }
+
+            const clang::CXXConstructorDecl* constructorDefinition = llvm::cast<clang::CXXConstructorDecl>(definition);
+
+            std::vector<const clang::CXXCtorInitializer*> initializers;
+            bool valid = true;
+            for (const clang::CXXCtorInitializer* initializer : constructorDefinition->inits())
+            {
+                if (!initializer->isWritten() || !initializer->isMemberInitializer())
+                {
+                    continue;
+                }
+
+                if (initializer->getSourceRange().getBegin().isMacroID() || initializer->getSourceRange().getEnd().isMacroID())
+                {
+                    valid = false;
+                    break;
+                }
+
+                initializers.push_back(initializer);
+            }
+
+            if (!valid || initializers.size() < 2)
+            {
+                continue;
+            }
+
+            std::sort(initializers.begin(), initializers.end(), [](const clang::CXXCtorInitializer* a, const clang::CXXCtorInitializer* b) { return a->getSourceOrder() < b->getSourceOrder(); });
+
+            std::vector<const clang::CXXCtorInitializer*> sorted = initializers;
+            std::stable_sort(sorted.begin(), sorted.end(), [&](const clang::CXXCtorInitializer* a, const clang::CXXCtorInitializer* b) { return newIndex[a->getMember()] < newIndex[b->getMember()]; });
+
+            bool changed = false;
+            for (size_t i = 0; i < initializers.size(); ++i)
+            {
+                if (initializers[i] != sorted[i])
+                {
+                    const clang::CharSourceRange sourceRange = clang::CharSourceRange::getTokenRange(sorted[i]->getSourceRange());
+                    rewriter.ReplaceText(initializers[i]->getSourceRange(), clang::Lexer::getSourceText(sourceRange, sourceManager, langOptions));
+                    changed = true;
+                }
+            }
+
+            numConstructors += changed ? 1u : 0u;
+        }
+
+        return numConstructors;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool ExportDiff(const clang::Rewriter& rewriter, const clang::SourceManager& sourceManager, const char* filename)
+    {
+        std::error_code errorCode;
+        llvm::raw_fd_ostream out(filename, errorCode, llvm::sys::fs::OF_Text);
+        if (errorCode)
+        {
+            LOG_ERROR("Unable to open '%s' for writing: %s", filename, errorCode.message().c_str());
+            return false;
+        }
+
+        for (clang::Rewriter::const_buffer_iterator it = rewriter.buffer_begin(), end = rewriter.buffer_end(); it != end; ++it)
+        {
+            const std::string after(it->second.begin(), it->second.end());
+            const llvm::StringRef before = sourceManager.getBufferData(it->first);
+            const llvm::StringRef path = sourceManager.getFilename(sourceManager.getLocForStartOfFile(it->first));
+            Diff::WriteUnified(out, path, before, after);
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Apply(clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const Params& params)
+    {
+        clang::SourceManager& sourceManager = context.getSourceManager();
+
+        TSlots slots;
+        clang::FileID fileId;
+        if (!CollectSlots(slots, context, declaration, fileId))
+        {
+            return false;
+        }
+
+        ComputeRanks(slots, context, params);
+
+        clang::Rewriter rewriter(sourceManager, context.getLangOpts());
+
+        std::vector<const clang::FieldDecl*> newOrder;
+        ReorderFields(newOrder, rewriter, slots, sourceManager, fileId);
+
+        //nothing is written when a field would be read before its initialization
+        if (!CheckInitializerDependencies(declaration, newOrder, context))
+        {
+            return false;
+        }
+
+        const unsigned int numConstructors = ReorderInitializers(rewriter, declaration, newOrder, context);
+
+        if (rewriter.buffer_begin() == rewriter.buffer_end())
+        {
+            LOG_PROGRESS("'%s' already follows the requested field order.", declaration->getQualifiedNameAsString().c_str());
+        }
+        else
+        {
+            LOG_PROGRESS("Reordered the fields of '%s' (%u constructors updated).", declaration->getQualifiedNameAsString().c_str(), numConstructors);
+        }
+
+        bool ret = true;
+        if (!params.diffFilename.empty())
+        {
+            ret = ExportDiff(rewriter, sourceManager, params.diffFilename.c_str());
+        }
+
+        if (ret && params.inPlace && rewriter.overwriteChangedFiles())
+        {
+            LOG_ERROR("Unable to write the reordered files back to disk.");
+            ret = false;
+        }
+
+        return ret;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace clang
+{
+    class ASTContext;
+    class CXXRecordDecl;
+}
+
+namespace FieldReorder
+{
+    struct Params
+    {
+        std::vector<std::string> fieldOrder;   //explicit order, when empty the fields are sorted by alignment
+        std::string              diffFilename;
+        bool                     inPlace = false;
+    };
+
+    bool Apply(clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const Params& params);
+}
@@ -0,0 +1,87 @@
+#include "Instantiation.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/Sema/Sema.h>
+
+#pragma warning(pop)
+
+#include "IO.h"
+
+namespace Instantiation
+{
+    constexpr const char* NAMESPACE_NAME = "StructLayoutInstantiations";
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        const clang::NamespaceDecl* FindNamespace(const clang::ASTContext& context)
+        {
+            for (const clang::Decl* declaration : context.getTranslationUnitDecl()->decls())
+            {
+                const clang::NamespaceDecl* namespaceDeclaration = llvm::dyn_cast<clang::NamespaceDecl>(declaration);
+                if (namespaceDeclaration && namespaceDeclaration->getIdentifier() && namespaceDeclaration->getName() == NAMESPACE_NAME)
+                {
+                    return namespaceDeclaration;
+                }
+            }
+            return nullptr;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::string GetInjectedSource(const TSpellings& spellings)
+    {
+        //the line directive keeps the main file locations untouched and names the spellings in the diagnostics
+        std::string source = "\n#line 1 \"<instantiations>\"\nnamespace ";
+        source += NAMESPACE_NAME;
+        source += "\n{\n";
+        for (size_t i = 0; i < spellings.size(); ++i)
+        {
+            source += "    using Instantiation" + std::to_string(i) + " = " + spellings[i] + ";\n";
+        }
+        source += "}\n";
+        return source;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Resolve(TRecords& output, clang::Sema& sema, const TSpellings& spellings)
+    {
+        output.assign(spellings.size(), nullptr);
+
+        const clang::NamespaceDecl* namespaceDeclaration = Helpers::FindNamespace(sema.getASTContext());
+        if (!namespaceDeclaration)
+        {
+            LOG_ERROR("Unable to find the injected instantiations");
+            return;
+        }
+
+        size_t index = 0u;
+        for (const clang::Decl* declaration : namespaceDeclaration->decls())
+        {
+            const clang::TypeAliasDecl* alias = llvm::dyn_cast<clang::TypeAliasDecl>(declaration);
+            if (!alias || index >= spellings.size())
+            {
+                continue;
+            }
+
+            //an alias alone does not instantiate the specialization, asking for a complete type does
+            const clang::QualType type = alias->getUnderlyingType().getCanonicalType();
+            const clang::CXXRecordDecl* record = type->getAsCXXRecordDecl();
+            if (!alias->isInvalidDecl() && record && !type->isDependentType() && sema.isCompleteType(alias->getLocation(), type))
+            {
+                output[index] = record->getDefinition();
+            }
+            else
+            {
+                LOG_ERROR("Unable to instantiate '%s' as a complete record", spellings[index].c_str());
+            }
+
+            ++index;
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace clang
+{
+    class CXXRecordDecl;
+    class Sema;
+}
+
+namespace Instantiation
+{
+    using TSpellings = std::vector<std::string>;
+    using TRecords   = std::vector<const clang::CXXRecordDecl*>;
+
+    // Declarations appended to the main file so Sema looks up each spelling, nothing is instantiated yet
+    std::string GetInjectedSource(const TSpellings& spellings);
+
+    // Forces the completion of each injected type, one entry per spelling and null when it is not a complete record
+    void Resolve(TRecords& output, clang::Sema& sema, const TSpellings& spellings);
+}
@@ -0,0 +1,397 @@
+#include "LayoutCache.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Attr.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/RecordLayout.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Basic/TargetInfo.h>
+#include <clang/Lex/MacroInfo.h>
+#include <clang/Lex/PPCallbacks.h>
+#include <clang/Lex/Preprocessor.h>
+
+// LLVM includes
+#include <llvm/Support/xxhash.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace LayoutCache
+{
+    enum { MAX_DEPTH = 32 };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        // moves location file indices from one file list to another, only adding the files actually referenced
+        struct FileRemap
+        {
+            FileRemap(Layout::TFiles& output, const Layout::TFiles& input, TFileIndices* outputIndices = nullptr)
+                : output(output)
+                , input(input)
+                , outputIndices(outputIndices)
+                , indices(input.size(), Layout::INVALID_FILE_INDEX)
+            {}
+
+            int Get(const int index)
+            {
+                if (index < 0 || index >= static_cast<int>(indices.size()))
+                {
+                    return Layout::INVALID_FILE_INDEX;
+                }
+
+                if (indices[index] == Layout::INVALID_FILE_INDEX)
+                {
+                    indices[index] = outputIndices ? FindIndexed(input[index]) : Find(input[index]);
+                }
+                return indices[index];
+            }
+
+            int Find(const std::string& file)
+            {
+                const Layout::TFiles::const_iterator found = std::find(output.begin(), output.end(), file);
+                if (found == output.end())
+                {
+                    output.push_back(file);
+                    return static_cast<int>(output.size() - 1);
+                }
+                return static_cast<int>(found - output.begin());
+            }
+
+            int FindIndexed(const std::string& file)
+            {
+                const std::pair<TFileIndices::iterator, bool> inserted = outputIndices->emplace(file, static_cast<int>(output.size()));
+                if (inserted.second)
+                {
+                    output.push_back(file);
+                }
+                return inserted.first->second;
+            }
+
+            Layout::TFiles&       output;
+            const Layout::TFiles& input;
+            TFileIndices*         outputIndices; //the cache file list is too large to search
+            std::vector<int>      indices;
+        };
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::Node* CloneTree(const Layout::Node& node, FileRemap& fileRemap)
+        {
+            Layout::Node* clone = new Layout::Node(node);
+            clone->typeLocation.fileIndex  = fileRemap.Get(node.typeLocation.fileIndex);
+            clone->fieldLocation.fileIndex = fileRemap.Get(node.fieldLocation.fileIndex);
+
+            for (Layout::Node*& child : clone->children)
+            {
+                child = CloneTree(*child, fileRemap);
+            }
+            return clone;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void DestroyTree(Layout::Node* node)
+        {
+            for (Layout::Node* child : node->children)
+            {
+                DestroyTree(child);
+            }
+            delete node;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void CollectFiles(std::vector<clang::FileID>& output, const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const unsigned int depth)
+        {
+            const clang::SourceManager& sourceManager = context.getSourceManager();
+            const clang::FileID fileId = sourceManager.getFileID(sourceManager.getExpansionLoc(declaration->getLocation()));
+            if (std::find(output.begin(), output.end(), fileId) == output.end())
+            {
+                output.push_back(fileId);
+            }
+
+            if (depth >= MAX_DEPTH)
+            {
+                return;
+            }
+
+            for (const clang::CXXBaseSpecifier& base : declaration->bases())
+            {
+                CollectFiles(output, context, base.getType()->getAsCXXRecordDecl(), depth + 1);
+            }
+
+            for (const clang::CXXBaseSpecifier& base : declaration->vbases())
+            {
+                CollectFiles(output, context, base.getType()->getAsCXXRecordDecl(), depth + 1);
+            }
+
+            for (const clang::FieldDecl* field : declaration->fields())
+            {
+                const clang::QualType type = context.getBaseElementType(field->getType());
+                if (const clang::CXXRecordDecl* record = type->getAsCXXRecordDecl())
+                {
+                    CollectFiles(output, context, record, depth + 1);
+                }
+                else if (const clang::EnumType* enumType = type->getAs<clang::EnumType>())
+                {
+                    //the underlying type of an unfixed enum depends on its enumerators
+                    const clang::FileID enumFileId = sourceManager.getFileID(sourceManager.getExpansionLoc(enumType->getDecl()->getLocation()));
+                    if (std::find(output.begin(), output.end(), enumFileId) == output.end())
+                    {
+                        output.push_back(enumFileId);
+                    }
+                }
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void AppendPacking(std::string& output, const clang::CXXRecordDecl* declaration, const unsigned int depth)
+        {
+            //#pragma pack is not a macro, it reaches the layout through these attributes
+            const clang::MaxFieldAlignmentAttr* packAttribute = declaration->getAttr<clang::MaxFieldAlignmentAttr>();
+            output += std::to_string(packAttribute ? packAttribute->getAlignment() : 0u) + (declaration->hasAttr<clang::PackedAttr>() ? "p" : "") + ';';
+
+            if (depth >= MAX_DEPTH)
+            {
+                return;
+            }
+
+            for (const clang::CXXBaseSpecifier& base : declaration->bases())
+            {
+                AppendPacking(output, base.getType()->getAsCXXRecordDecl(), depth + 1);
+            }
+
+            for (const clang::FieldDecl* field : declaration->fields())
+            {
+                if (const clang::CXXRecordDecl* record = field->getType()->getBaseElementTypeUnsafe()->getAsCXXRecordDecl())
+                {
+                    AppendPacking(output, record, depth + 1);
+                }
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void AppendLayout(std::string& output, const clang::ASTContext& context, UnitState& state, const clang::CXXRecordDecl* declaration, const bool includeVirtualBases)
+        {
+            //the declaring files miss what typedefs, template arguments or array and alignas constants from other headers do to the layout
+            const clang::ASTRecordLayout& layout = context.getASTRecordLayout(declaration);
+            output += std::to_string(layout.getSize().getQuantity()) + ',' + std::to_string(layout.getAlignment().getQuantity()) + ';';
+
+            //the nested records bring their own keys, computed once per unit
+            for (const clang::CXXBaseSpecifier& base : declaration->bases())
+            {
+                const clang::CXXRecordDecl* record = base.getType()->getAsCXXRecordDecl();
+                if (record && !base.isVirtual())
+                {
+                    output += 'b' + std::to_string(layout.getBaseClassOffset(record).getQuantity()) + '#' + std::to_string(ComputeKey(context, state, record, false)) + ';';
+                }
+            }
+
+            if (includeVirtualBases)
+            {
+                for (const clang::CXXBaseSpecifier& base : declaration->vbases())
+                {
+                    const clang::CXXRecordDecl* record = base.getType()->getAsCXXRecordDecl();
+                    if (record)
+                    {
+                        output += 'v' + std::to_string(layout.getVBaseClassOffset(record).getQuantity()) + '#' + std::to_string(ComputeKey(context, state, record, false)) + ';';
+                    }
+                }
+            }
+
+            //written and canonical types so the displayed spelling and the actual type both count
+            unsigned int fieldNo = 0u;
+            for (const clang::FieldDecl* field : declaration->fields())
+            {
+                const clang::QualType type = field->getType();
+                output += type.getAsString() + '=' + type.getCanonicalType().getAsString() + '@' + std::to_string(layout.getFieldOffset(fieldNo++));
+
+                if (field->isBitField())
+                {
+                    output += ':' + std::to_string(field->getBitWidthValue(context));
+                }
+                else
+                {
+                    const clang::TypeInfo info = context.getTypeInfo(type);
+                    output += ',' + std::to_string(info.Width) + ',' + std::to_string(info.Align);
+                }
+
+                if (const clang::CXXRecordDecl* record = type->getAsCXXRecordDecl())
+                {
+                    output += '#' + std::to_string(ComputeKey(context, state, record, true));
+                }
+                output += ';';
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        uint64_t GetContentHash(FileState& state, const clang::SourceManager& sourceManager, const clang::FileID fileId)
+        {
+            if (!state.isHashed)
+            {
+                const std::optional<llvm::MemoryBufferRef> buffer = sourceManager.getBufferOrNone(fileId);
+                state.contentHash = buffer ? llvm::xxHash64(buffer->getBuffer()) : 0u;
+                state.isHashed    = true;
+            }
+            return state.contentHash;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    class MacroRecorder : public clang::PPCallbacks
+    {
+    public:
+        MacroRecorder(UnitState& output, const clang::Preprocessor& preprocessor)
+            : m_output(output.files)
+            , m_preprocessor(preprocessor)
+        {}
+
+        void MacroExpands(const clang::Token& name, const clang::MacroDefinition& definition, clang::SourceRange range, const clang::MacroArgs*) override { Record(range.getBegin(), name, definition); }
+        void Defined(const clang::Token& name, const clang::MacroDefinition& definition, clang::SourceRange range) override                             { Record(range.getBegin(), name, definition); }
+        void Ifdef(clang::SourceLocation location, const clang::Token& name, const clang::MacroDefinition& definition) override                        { Record(location, name, definition); }
+        void Ifndef(clang::SourceLocation location, const clang::Token& name, const clang::MacroDefinition& definition) override                       { Record(location, name, definition); }
+        void Elifdef(clang::SourceLocation location, const clang::Token& name, const clang::MacroDefinition& definition) override                      { Record(location, name, definition); }
+        void Elifndef(clang::SourceLocation location, const clang::Token& name, const clang::MacroDefinition& definition) override                     { Record(location, name, definition); }
+
+    private:
+        void Record(const clang::SourceLocation location, const clang::Token& name, const clang::MacroDefinition& definition)
+        {
+            const clang::SourceManager& sourceManager = m_preprocessor.getSourceManager();
+            const clang::FileID fileId = sourceManager.getFileID(sourceManager.getExpansionLoc(location));
+            if (!fileId.isValid())
+            {
+                return;
+            }
+
+            const clang::MacroInfo* info = definition.getMacroInfo();
+            const uint64_t nameHash = llvm::xxHash64(name.getIdentifierInfo() ? name.getIdentifierInfo()->getName() : llvm::StringRef());
+            m_output[fileId.getHashValue()].macros.insert(nameHash ^ (info ? GetDefinitionHash(info) : 0u));
+        }
+
+        uint64_t GetDefinitionHash(const clang::MacroInfo* info)
+        {
+            const TDefinitionHashes::const_iterator found = m_definitionHashes.find(info);
+            if (found != m_definitionHashes.end())
+            {
+                return found->second;
+            }
+
+            //the spelling of the replacement list, the location would not tell apart two -D values
+            std::string text = info->isFunctionLike() ? "(" + std::to_string(info->getNumParams()) + ")" : "=";
+            for (const clang::Token& token : info->tokens())
+            {
+                text += m_preprocessor.getSpelling(token) + ' ';
+            }
+
+            const uint64_t hash = llvm::xxHash64(text) | 1u;
+            m_definitionHashes.emplace(info, hash);
+            return hash;
+        }
+
+    private:
+        using TDefinitionHashes = std::unordered_map<const clang::MacroInfo*, uint64_t>;
+
+        TFileStates&               m_output;
+        const clang::Preprocessor& m_preprocessor;
+        TDefinitionHashes          m_definitionHashes;
+    };
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::unique_ptr<clang::PPCallbacks> CreateMacroRecorder(UnitState& output, const clang::Preprocessor& preprocessor)
+    {
+        return std::make_unique<MacroRecorder>(output, preprocessor);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    uint64_t ComputeKey(const clang::ASTContext& context, UnitState& state, const clang::CXXRecordDecl* declaration, const bool includeVirtualBases)
+    {
+        TKeys& keys = includeVirtualBases ? state.keys : state.baseKeys;
+        const TKeys::const_iterator found = keys.find(declaration);
+        if (found != keys.end())
+        {
+            return found->second;
+        }
+
+        const clang::SourceManager& sourceManager = context.getSourceManager();
+        const clang::TargetInfo& target = context.getTargetInfo();
+
+        //the record itself, specializations share the location of their pattern
+        const clang::SourceLocation location = sourceManager.getExpansionLoc(declaration->getLocation());
+        std::string text = context.getRecordType(declaration).getAsString() + '@' + std::to_string(sourceManager.getFileOffset(location)) + (includeVirtualBases ? ";" : ";base;");
+
+        //target and the flags that change the layout without a macro
+        text += target.getTriple().str() + ';' + std::to_string(static_cast<int>(target.getCXXABI().getKind())) + ';' + std::to_string(context.getLangOpts().PackStruct) + ';' + std::to_string(context.getLangOpts().MaxTypeAlign) + ';';
+        Helpers::AppendPacking(text, declaration, 0u);
+        Helpers::AppendLayout(text, context, state, declaration, includeVirtualBases);
+
+        std::vector<clang::FileID> files;
+        Helpers::CollectFiles(files, context, declaration, 0u);
+
+        std::vector<std::string> fileTexts;
+        for (const clang::FileID fileId : files)
+        {
+            FileState& fileState = state.files[fileId.getHashValue()];
+
+            //the macro hashes are combined without depending on the order they were used in
+            uint64_t macros = 0u;
+            for (const uint64_t macro : fileState.macros)
+            {
+                macros ^= macro;
+            }
+
+            const llvm::StringRef filename = sourceManager.getFilename(sourceManager.getLocForStartOfFile(fileId));
+            fileTexts.push_back(filename.str() + ':' + std::to_string(Helpers::GetContentHash(fileState, sourceManager, fileId)) + ':' + std::to_string(macros) + ':' + std::to_string(fileState.macros.size()));
+        }
+
+        std::sort(fileTexts.begin(), fileTexts.end());
+        for (const std::string& fileText : fileTexts)
+        {
+            text += fileText + ';';
+        }
+
+        const uint64_t key = llvm::xxHash64(text);
+        keys.emplace(declaration, key);
+        return key;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    Cache::~Cache()
+    {
+        for (TEntries::value_type& entry : m_entries)
+        {
+            Helpers::DestroyTree(entry.second);
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    Layout::Node* Cache::Fetch(Layout::TFiles& files, const uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const TEntries::const_iterator found = m_entries.find(key);
+        if (found == m_entries.end())
+        {
+            return nullptr;
+        }
+
+        Helpers::FileRemap fileRemap(files, m_files);
+        return Helpers::CloneTree(*found->second, fileRemap);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Cache::Store(const uint64_t key, const Layout::Node& node, const Layout::TFiles& files)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_entries.find(key) == m_entries.end())
+        {
+            Helpers::FileRemap fileRemap(m_files, files, &m_fileIndices);
+            m_entries.emplace(key, Helpers::CloneTree(node, fileRemap));
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "LayoutDefinitions.h"
+
+namespace clang
+{
+    class ASTContext;
+    class CXXRecordDecl;
+    class PPCallbacks;
+    class Preprocessor;
+}
+
+namespace LayoutCache
+{
+    // What a file contributes to the layouts it declares within one translation unit
+    struct FileState
+    {
+        std::unordered_set<uint64_t> macros;          //hashes of the macro names and definitions tested or expanded in the file
+        uint64_t                     contentHash = 0u;
+        bool                         isHashed    = false;
+    };
+
+    using TFileStates  = std::unordered_map<unsigned int, FileState>; //by FileID hash value
+    using TKeys        = std::unordered_map<const clang::CXXRecordDecl*, uint64_t>;
+    using TFileIndices = std::unordered_map<std::string, int>;
+
+    // Per translation unit state, cleared before each parse
+    struct UnitState
+    {
+        TFileStates files;
+        TKeys       keys;
+        TKeys       baseKeys; //base subobjects are laid out without their virtual bases
+    };
+
+    // Records the macro state of each file while preprocessing
+    std::unique_ptr<clang::PPCallbacks> CreateMacroRecorder(UnitState& output, const clang::Preprocessor& preprocessor);
+
+    // Hashes the path, contents and macro state of every file declaring the record or its nested types, along with the target
+    // and the record layout itself: offsets, written and canonical field types, sizes and the keys of the nested records
+    uint64_t ComputeKey(const clang::ASTContext& context, UnitState& state, const clang::CXXRecordDecl* declaration, const bool includeVirtualBases);
+
+    // Computed layouts shared by every translation unit and thread of the run
+    class Cache
+    {
+    public:
+        ~Cache();
+
+        // Copies the cached layout remapping its locations into the given files, null when the key is not cached
+        Layout::Node* Fetch(Layout::TFiles& files, const uint64_t key);
+
+        void Store(const uint64_t key, const Layout::Node& node, const Layout::TFiles& files);
+
+    private:
+        using TEntries = std::unordered_map<uint64_t, Layout::Node*>;
+
+        std::mutex     m_mutex;
+        TEntries       m_entries;
+        Layout::TFiles m_files;       //the cached locations index these
+        TFileIndices   m_fileIndices;
+    };
+}
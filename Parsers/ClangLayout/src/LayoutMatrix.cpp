@@ -0,0 +1,232 @@
+#include "LayoutMatrix.h"
+
+#pragma warning(push, 0)
+
+// LLVM includes
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace LayoutMatrix
+{
+    enum { CACHE_LINE_SIZE = 64, MIN_CELL_WIDTH = 12 };
+
+    struct Cell
+    {
+        Layout::TAmount offset;
+        Layout::TAmount size;
+        Layout::TAmount bitOffset; //bitfields only
+        Layout::TAmount bitSize;   //bitfields only
+    };
+
+    using TRowNames = std::vector<std::string>;
+    using TCells    = std::unordered_map<std::string, Cell>;
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        std::string GetLabel(const Layout::Node& node)
+        {
+            switch (node.nature)
+            {
+            case Layout::Category::VTablePtr:
+            case Layout::Category::VFTablePtr:    return "<vptr>";
+            case Layout::Category::VBTablePtr:    return "<vbptr>";
+            case Layout::Category::VtorDisp:      return "<vtordisp>";
+            case Layout::Category::NVPrimaryBase:
+            case Layout::Category::NVBase:        return "<base " + node.type + ">";
+            case Layout::Category::VPrimaryBase:
+            case Layout::Category::VBase:         return "<virtual base " + node.type + ">";
+            default:                              return node.name.empty() ? std::string("(anonymous)") : node.name;
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsBase(const Layout::Category nature)
+        {
+            return nature == Layout::Category::NVPrimaryBase || nature == Layout::Category::NVBase || nature == Layout::Category::VPrimaryBase || nature == Layout::Category::VBase;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        std::string FormatCell(const Cell* cell)
+        {
+            if (!cell)
+            {
+                return "-";
+            }
+
+            std::string text = std::to_string(cell->offset);
+            if (cell->bitSize > 0)
+            {
+                text += '.' + std::to_string(cell->bitOffset) + ':' + std::to_string(cell->bitSize) + 'b';
+            }
+            else
+            {
+                text += '+' + std::to_string(cell->size);
+            }
+            return text;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsSameCell(const Cell* a, const Cell* b)
+        {
+            return a && b ? a->offset == b->offset && a->size == b->size && a->bitOffset == b->bitOffset && a->bitSize == b->bitSize : a == b;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // base members are listed as the record own members, the other nested records stay one row
+    void Flatten(TRowNames& rowNames, TCells& cells, const Layout::Node& node, const Layout::TAmount offset, const std::string& prefix)
+    {
+        for (const Layout::Node* child : node.children)
+        {
+            const std::string path = prefix + Helpers::GetLabel(*child);
+            const Layout::TAmount childOffset = offset + child->offset;
+
+            Cell cell{ childOffset, child->size, 0, 0 };
+            if (child->nature == Layout::Category::Bitfield && !child->children.empty())
+            {
+                cell.bitOffset = child->children[0]->offset;
+                cell.bitSize   = child->children[0]->size;
+            }
+
+            if (cells.emplace(path, cell).second && std::find(rowNames.begin(), rowNames.end(), path) == rowNames.end())
+            {
+                rowNames.push_back(path);
+            }
+
+            if (Helpers::IsBase(child->nature))
+            {
+                Flatten(rowNames, cells, *child, childOffset, path + '.');
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void WriteRow(llvm::raw_ostream& out, const std::string& name, const std::vector<std::string>& texts, const bool isDifferent, const size_t nameWidth, const size_t cellWidth)
+    {
+        out << (isDifferent ? "* " : "  ") << llvm::left_justify(name, static_cast<unsigned int>(nameWidth));
+        for (const std::string& text : texts)
+        {
+            out << llvm::right_justify(text, static_cast<unsigned int>(cellWidth));
+        }
+        out << "\n";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // compares each column against the first one to show which members account for the size change
+    void WriteDrivers(llvm::raw_ostream& out, const TRowNames& rowNames, const std::vector<TCells>& cells, const TColumns& columns)
+    {
+        if (columns.size() < 2 || !columns[0].root)
+        {
+            return;
+        }
+
+        out << "  Size drivers against " << columns[0].name << ":\n";
+        for (size_t i = 1; i < columns.size(); ++i)
+        {
+            if (!columns[i].root)
+            {
+                out << "    " << columns[i].name << ": record not found\n";
+                continue;
+            }
+
+            const Layout::TAmount delta = columns[i].root->size - columns[0].root->size;
+            out << "    " << columns[i].name << ": sizeof " << columns[0].root->size << " -> " << columns[i].root->size << " (" << (delta > 0 ? "+" : "") << delta << " bytes)\n";
+
+            for (const std::string& rowName : rowNames)
+            {
+                const TCells::const_iterator baseline = cells[0].find(rowName);
+                const TCells::const_iterator current  = cells[i].find(rowName);
+                const bool inBaseline = baseline != cells[0].end();
+                const bool inCurrent  = current != cells[i].end();
+
+                if (inCurrent && !inBaseline)
+                {
+                    out << "      added    " << rowName << " (" << current->second.size << " bytes)\n";
+                }
+                else if (inBaseline && !inCurrent)
+                {
+                    out << "      removed  " << rowName << " (" << baseline->second.size << " bytes)\n";
+                }
+                else if (inBaseline && baseline->second.size != current->second.size)
+                {
+                    out << "      resized  " << rowName << " " << baseline->second.size << " -> " << current->second.size << " bytes\n";
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Write(llvm::raw_ostream& out, const char* title, const TColumns& columns)
+    {
+        TRowNames rowNames;
+        std::vector<TCells> cells(columns.size());
+        std::string recordName;
+
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            if (columns[i].root)
+            {
+                Flatten(rowNames, cells[i], *columns[i].root, 0, "");
+                recordName = recordName.empty() ? columns[i].root->type : recordName;
+            }
+        }
+
+        out << "\n== " << title << ": " << (recordName.empty() ? std::string("no record found") : recordName) << " ==\n";
+
+        size_t nameWidth = 12u;
+        for (const std::string& rowName : rowNames)
+        {
+            nameWidth = std::max(nameWidth, rowName.size() + 2u);
+        }
+
+        size_t cellWidth = MIN_CELL_WIDTH;
+        std::vector<std::string> texts;
+        for (const Column& column : columns)
+        {
+            cellWidth = std::max(cellWidth, column.name.size() + 2u);
+            texts.push_back(column.name);
+        }
+        WriteRow(out, "offset+size", texts, false, nameWidth, cellWidth);
+
+        unsigned int differences = 0u;
+        for (const std::string& rowName : rowNames)
+        {
+            texts.clear();
+            std::vector<const Cell*> rowCells;
+            for (const TCells& columnCells : cells)
+            {
+                const TCells::const_iterator found = columnCells.find(rowName);
+                rowCells.push_back(found != columnCells.end() ? &found->second : nullptr);
+                texts.push_back(Helpers::FormatCell(rowCells.back()));
+            }
+
+            const bool isDifferent = std::any_of(rowCells.begin(), rowCells.end(), [&](const Cell* cell) { return !Helpers::IsSameCell(cell, rowCells[0]); });
+            differences += isDifferent ? 1u : 0u;
+            WriteRow(out, rowName, texts, isDifferent, nameWidth, cellWidth);
+        }
+
+        //totals
+        std::vector<std::string> sizes, aligns, lines;
+        for (const Column& column : columns)
+        {
+            sizes.push_back(column.root ? std::to_string(column.root->size) : std::string("-"));
+            aligns.push_back(column.root ? std::to_string(column.root->align) : std::string("-"));
+            lines.push_back(column.root ? std::to_string((column.root->size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) : std::string("-"));
+        }
+
+        const auto IsUniform = [](const std::vector<std::string>& values) { return std::all_of(values.begin(), values.end(), [&](const std::string& value) { return value == values[0]; }); };
+        WriteRow(out, "sizeof", sizes, !IsUniform(sizes), nameWidth, cellWidth);
+        WriteRow(out, "alignof", aligns, !IsUniform(aligns), nameWidth, cellWidth);
+        WriteRow(out, "cache lines", lines, !IsUniform(lines), nameWidth, cellWidth);
+
+        out << "  " << differences << " of " << rowNames.size() << " members differ (marked with *)\n";
+
+        WriteDrivers(out, rowNames, cells, columns);
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "LayoutDefinitions.h"
+
+namespace llvm
+{
+    class raw_ostream;
+}
+
+namespace LayoutMatrix
+{
+    // The layout of the same record computed under one target or configuration
+    struct Column
+    {
+        std::string         name;
+        const Layout::Node* root; //null when the record was not found
+    };
+
+    using TColumns = std::vector<Column>;
+
+    void Write(llvm::raw_ostream& out, const char* title, const TColumns& columns);
+}
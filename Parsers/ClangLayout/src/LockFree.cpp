@@ -0,0 +1,183 @@
+#include "LockFree.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Basic/TargetInfo.h>
+
+// LLVM includes
+#include <llvm/ADT/MapVector.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <string>
+
+#include "Report.h"
+
+namespace LockFree
+{
+    enum { MAX_DEPTH = 8 };
+
+    using TAtomicRefFields = llvm::MapVector<const clang::FieldDecl*, clang::SourceLocation>;
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    class AtomicRefVisitor : public clang::RecursiveASTVisitor<AtomicRefVisitor>
+    {
+    public:
+        AtomicRefVisitor(const clang::RecordDecl* declaration, TAtomicRefFields& output)
+            : m_declaration(declaration->getCanonicalDecl())
+            , m_output(output)
+        {}
+
+        bool VisitCXXConstructExpr(clang::CXXConstructExpr* expression)
+        {
+            if (expression->getNumArgs() == 0 || !Report::IsStdType(expression->getType(), "atomic_ref"))
+            {
+                return true;
+            }
+
+            const clang::MemberExpr* member = llvm::dyn_cast<clang::MemberExpr>(expression->getArg(0)->IgnoreParenImpCasts());
+            const clang::FieldDecl* field = member ? llvm::dyn_cast<clang::FieldDecl>(member->getMemberDecl()) : nullptr;
+            if (field && field->getParent()->getCanonicalDecl() == m_declaration)
+            {
+                m_output.insert({ field, expression->getBeginLoc() });
+            }
+            return true;
+        }
+
+    private:
+        const clang::RecordDecl* m_declaration;
+        TAtomicRefFields&        m_output;
+    };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        clang::QualType GetValueType(const clang::QualType& type)
+        {
+            if (const clang::AtomicType* atomicType = type->getAs<clang::AtomicType>())
+            {
+                return atomicType->getValueType();
+            }
+
+            const clang::ClassTemplateSpecializationDecl* specialization = llvm::dyn_cast_or_null<clang::ClassTemplateSpecializationDecl>(type.getCanonicalType()->getAsCXXRecordDecl());
+            if (specialization && specialization->getTemplateArgs().size() > 0 && specialization->getTemplateArgs().get(0).getKind() == clang::TemplateArgument::Type)
+            {
+                return specialization->getTemplateArgs().get(0).getAsType();
+            }
+
+            return clang::QualType();
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        // same rules the compiler uses to decide between inline atomic instructions and the libatomic calls
+        const char* GetLockReason(const clang::ASTContext& context, const Layout::TAmount size, const Layout::TAmount align)
+        {
+            const Layout::TAmount maxInlineWidth = context.toCharUnitsFromBits(context.getTargetInfo().getMaxAtomicInlineWidth()).getQuantity();
+
+            if (size == 0 || (size & (size - 1)) != 0)
+            {
+                return "size is not a power of two";
+            }
+
+            if (size > maxInlineWidth)
+            {
+                return "size exceeds the target max lock-free width";
+            }
+
+            if (align < size)
+            {
+                return "alignment is smaller than the size";
+            }
+
+            return nullptr;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void WriteResult(const Report::Context& context, const std::string& path, const clang::QualType& type, const clang::QualType& valueType, const Layout::TAmount size, const Layout::TAmount align, unsigned int& locked)
+    {
+        const char* reason = Helpers::GetLockReason(context.ast, size, align);
+        locked += reason ? 1u : 0u;
+
+        const std::string valueName = valueType.isNull() ? std::string("?") : Report::GetTypeName(context.ast, valueType);
+        const Layout::TAmount valueSize = valueType.isNull() ? 0 : context.ast.getTypeSizeInChars(valueType).getQuantity();
+
+        context.out << "    " << llvm::left_justify(path, 40) << llvm::left_justify(Report::GetTypeName(context.ast, type), 40) << "T " << llvm::left_justify(valueName, 24) << "sizeof(T) " << llvm::format_decimal(valueSize, 3) << "  size " << llvm::format_decimal(size, 3) << "  align " << llvm::format_decimal(align, 3);
+        if (reason)
+        {
+            context.out << "  NOT lock-free: " << reason << "\n";
+        }
+        else
+        {
+            context.out << "  always lock-free\n";
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void AnalyzeRecord(const Report::Context& context, const clang::RecordDecl* declaration, const std::string& prefix, const unsigned int depth, unsigned int& found, unsigned int& locked)
+    {
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            const clang::QualType type = context.ast.getBaseElementType(field->getType());
+            const std::string path = prefix + (field->getName().empty() ? std::string("(anonymous)") : field->getNameAsString());
+
+            if (Report::IsStdType(type, "atomic") || type->isAtomicType())
+            {
+                const clang::TypeInfoChars info = context.ast.getTypeInfoInChars(type);
+                WriteResult(context, path, type, Helpers::GetValueType(type), info.Width.getQuantity(), std::max(info.Align.getQuantity(), context.ast.getDeclAlign(field).getQuantity()), locked);
+                ++found;
+            }
+            else if (const clang::RecordDecl* record = type->getAsRecordDecl())
+            {
+                if (depth < MAX_DEPTH && !record->isInStdNamespace())
+                {
+                    AnalyzeRecord(context, record, path + '.', depth + 1, found, locked);
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context)
+    {
+        Report::WriteTitle(context, "Lock-free atomics");
+
+        const clang::TargetInfo& target = context.ast.getTargetInfo();
+        context.out << "  Target: " << target.getTriple().str() << ", max lock-free width " << context.ast.toCharUnitsFromBits(target.getMaxAtomicInlineWidth()).getQuantity() << " bytes\n";
+
+        unsigned int found  = 0u;
+        unsigned int locked = 0u;
+
+        AnalyzeRecord(context, context.declaration, "", 0u, found, locked);
+
+        //plain fields used as atomic_ref targets anywhere in the translation unit
+        TAtomicRefFields atomicRefFields;
+        AtomicRefVisitor visitor(context.declaration, atomicRefFields);
+        visitor.TraverseDecl(context.ast.getTranslationUnitDecl());
+
+        for (const auto& entry : atomicRefFields)
+        {
+            const clang::FieldDecl* field = entry.first;
+            const clang::QualType type = field->getType();
+            WriteResult(context, field->getNameAsString() + " (atomic_ref at " + Report::GetLocationString(context.ast, entry.second) + ")", type, type, context.ast.getTypeSizeInChars(type).getQuantity(), context.ast.getDeclAlign(field).getQuantity(), locked);
+            ++found;
+        }
+
+        if (found == 0u)
+        {
+            context.out << "  No atomic fields found.\n";
+            return;
+        }
+
+        context.out << "  " << locked << " of " << found << " atomics fall back to a lock based implementation\n";
+    }
+}
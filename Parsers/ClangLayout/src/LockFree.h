@@ -0,0 +1,11 @@
+#pragma once
+
+namespace Report
+{
+    struct Context;
+}
+
+namespace LockFree
+{
+    void Analyze(const Report::Context& context);
+}
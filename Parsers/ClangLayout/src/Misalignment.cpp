@@ -0,0 +1,128 @@
+#include "Misalignment.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/RecordLayout.h>
+
+// LLVM includes
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <string>
+
+#include "Report.h"
+
+namespace Misalignment
+{
+    enum { MAX_DEPTH = 8, CACHE_LINE_SIZE = 64 };
+
+    struct Summary
+    {
+        unsigned int misaligned = 0u;
+        unsigned int splitLines = 0u;
+        unsigned int atomics    = 0u;
+    };
+
+    // -----------------------------------------------------------------------------------------------------------
+    void AnalyzeRecord(Summary& summary, const Report::Context& context, const clang::RecordDecl* declaration, const std::string& prefix, const Layout::TAmount baseOffset, const unsigned int depth)
+    {
+        const clang::ASTRecordLayout& layout = context.ast.getASTRecordLayout(declaration);
+
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            //bitfields are accessed through their storage unit
+            if (field->isBitField() || field->isZeroSize(context.ast))
+            {
+                continue;
+            }
+
+            const clang::QualType type = field->getType();
+            const Layout::TAmount offset = baseOffset + context.ast.toCharUnitsFromBits(layout.getFieldOffset(field->getFieldIndex())).getQuantity();
+            const Layout::TAmount align  = context.ast.getTypeAlignInChars(context.ast.getBaseElementType(type)).getQuantity();
+            const std::string path = prefix + (field->getName().empty() ? std::string("(anonymous)") : field->getNameAsString());
+
+            //nested records are reported through their own fields
+            const clang::RecordDecl* record = type->getAsRecordDecl();
+            if (record && !record->isInStdNamespace() && depth < MAX_DEPTH)
+            {
+                AnalyzeRecord(summary, context, record, path + '.', offset, depth + 1);
+                continue;
+            }
+
+            if (align <= 1 || offset % align == 0)
+            {
+                continue;
+            }
+
+            //only accesses of a single scalar or element are considered, arrays are expected to span lines
+            const Layout::TAmount accessSize = context.ast.getTypeSizeInChars(context.ast.getBaseElementType(type)).getQuantity();
+            const bool isSplit  = accessSize > 1 && accessSize <= CACHE_LINE_SIZE && (offset / CACHE_LINE_SIZE) != ((offset + accessSize - 1) / CACHE_LINE_SIZE);
+            const bool isAtomic = Report::IsAtomic(type);
+
+            summary.misaligned += 1u;
+            summary.splitLines += isSplit ? 1u : 0u;
+            summary.atomics    += isAtomic ? 1u : 0u;
+
+            context.out << "    " << llvm::left_justify(path, 40) << llvm::left_justify(Report::GetTypeName(context.ast, type), 32) << "offset " << llvm::format_decimal(offset, 5) << "  align " << llvm::format_decimal(align, 3) << "  off by " << (offset % align);
+            if (isSplit)
+            {
+                context.out << "  [splits a cache line]";
+            }
+            if (isAtomic)
+            {
+                context.out << "  [atomic, accesses are not atomic]";
+            }
+            context.out << "\n";
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context)
+    {
+        Report::WriteTitle(context, "Misaligned fields");
+
+        Summary summary;
+        context.out << "  Fields:\n";
+        AnalyzeRecord(summary, context, context.declaration, "", 0, 0u);
+
+        if (summary.misaligned == 0u)
+        {
+            context.out << "    No misaligned fields found.\n";
+            return;
+        }
+
+        //what the packing is buying compared to the natural alignment of the same fields
+        Report::Shape shape;
+        Report::ComputeShape(shape, context.ast, context.declaration);
+
+        Report::Shape natural = shape;
+        for (Report::Member& member : natural.members)
+        {
+            member.align = context.ast.getTypeAlignInChars(member.field->getType()).getQuantity();
+        }
+
+        const Layout::TAmount currentSize   = context.ast.getASTRecordLayout(context.declaration).getSize().getQuantity();
+        const Layout::TAmount naturalSize   = Report::ComputeSize(natural);
+        const Layout::TAmount reorderedSize = Report::ComputeSortedSize(natural);
+
+        context.out << "  Summary:\n";
+        context.out << "    " << summary.misaligned << " misaligned fields, " << summary.splitLines << " splitting a " << CACHE_LINE_SIZE << " byte cache line, " << summary.atomics << " atomic\n";
+        context.out << "    size packed: " << currentSize << " bytes, naturally aligned: " << naturalSize << " bytes, naturally aligned + reorder: " << reorderedSize << " bytes\n";
+        context.out << "  Cost:\n";
+        context.out << "    misaligned loads and stores are slower on most targets and fault or get split into byte accesses on strict alignment ones\n";
+        if (summary.splitLines > 0u)
+        {
+            context.out << "    cache line splits touch two lines per access and are several times slower than aligned accesses\n";
+        }
+        if (summary.atomics > 0u)
+        {
+            context.out << "    misaligned atomics lose their atomicity or take a bus lock on every access\n";
+        }
+        context.out << "    taking the address of a misaligned field and dereferencing it through a plain pointer is undefined behavior\n";
+    }
+}
@@ -0,0 +1,170 @@
+#include "OverAlignment.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/RecordLayout.h>
+#include <clang/Basic/TargetInfo.h>
+
+// LLVM includes
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <string>
+
+#include "Report.h"
+
+namespace OverAlignment
+{
+    enum { MAX_DEPTH = 8, ELEMENT_COUNT = 1000 };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount GetNaturalAlign(const clang::ASTContext& context, const clang::QualType& type)
+        {
+            //the alignment the type would have without any alignas or aligned attribute
+            const clang::QualType elementType = context.getBaseElementType(type);
+            const clang::CXXRecordDecl* declaration = elementType->getAsCXXRecordDecl();
+            if (!declaration || !declaration->hasDefinition())
+            {
+                return context.getTypeAlignInChars(elementType.getCanonicalType()).getQuantity();
+            }
+
+            Layout::TAmount align = 1;
+            if (declaration->isDynamicClass())
+            {
+                align = context.toCharUnitsFromBits(context.getTargetInfo().getPointerAlign(clang::LangAS::Default)).getQuantity();
+            }
+
+            for (const clang::CXXBaseSpecifier& base : declaration->bases())
+            {
+                align = std::max(align, GetNaturalAlign(context, base.getType()));
+            }
+
+            for (const clang::FieldDecl* field : declaration->fields())
+            {
+                align = std::max(align, GetNaturalAlign(context, field->getType()));
+            }
+
+            return align;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount GetNewAlign(const clang::ASTContext& context)
+        {
+            return context.toCharUnitsFromBits(context.getTargetInfo().getNewAlign()).getQuantity();
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount GetPayload(const clang::ASTContext& context, const clang::QualType& type)
+        {
+            const clang::CXXRecordDecl* declaration = type->getAsCXXRecordDecl();
+            return declaration && declaration->hasDefinition() ? Report::GetDataEnd(context, declaration) : context.getTypeSizeInChars(type).getQuantity();
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // returns the waste per element
+    Layout::TAmount WriteType(const Report::Context& context, const std::string& name, const clang::QualType& type)
+    {
+        const Layout::TAmount align   = context.ast.getTypeAlignInChars(type).getQuantity();
+        const Layout::TAmount natural = Helpers::GetNaturalAlign(context.ast, type);
+        const Layout::TAmount stride  = context.ast.getTypeSizeInChars(type).getQuantity();
+        const Layout::TAmount payload = Helpers::GetPayload(context.ast, type);
+        const Layout::TAmount newAlign = Helpers::GetNewAlign(context.ast);
+
+        context.out << "    " << llvm::left_justify(name, 40) << "align " << llvm::format_decimal(align, 4) << " (natural " << natural << ")  payload " << llvm::format_decimal(payload, 6) << "  stride " << llvm::format_decimal(stride, 6);
+        context.out << "  usage " << llvm::format_decimal(stride > 0 ? (payload * 100) / stride : 100, 3) << "%  " << (stride - payload) * ELEMENT_COUNT << " bytes wasted per " << ELEMENT_COUNT << " elements\n";
+
+        if (align > newAlign)
+        {
+            context.out << "      heap allocations go through the aligned operator new (alignment " << align << " > __STDCPP_DEFAULT_NEW_ALIGNMENT__ " << newAlign << ")\n";
+        }
+
+        return stride - payload;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    unsigned int AnalyzeFields(const Report::Context& context, const clang::RecordDecl* declaration, const std::string& prefix, const unsigned int depth)
+    {
+        const clang::ASTRecordLayout& layout = context.ast.getASTRecordLayout(declaration);
+
+        unsigned int found = 0u;
+        Layout::TAmount previousEnd = 0;
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            const clang::QualType type = field->getType();
+            const clang::QualType elementType = context.ast.getBaseElementType(type);
+            const std::string path = prefix + (field->getName().empty() ? std::string("(anonymous)") : field->getNameAsString());
+
+            const uint64_t bitOffset = layout.getFieldOffset(field->getFieldIndex());
+            const Layout::TAmount offset = context.ast.toCharUnitsFromBits(bitOffset).getQuantity();
+
+            if (field->isBitField())
+            {
+                previousEnd = context.ast.toCharUnitsFromBits(Report::AlignTo(bitOffset + field->getBitWidthValue(context.ast), context.ast.getCharWidth())).getQuantity();
+                continue;
+            }
+
+            const Layout::TAmount typeAlign = context.ast.getTypeAlignInChars(elementType).getQuantity();
+            const Layout::TAmount declAlign = context.ast.getDeclAlign(field).getQuantity();
+
+            //over-aligned element types, stored as the field or as an array of them
+            if (typeAlign > Helpers::GetNaturalAlign(context.ast, elementType))
+            {
+                ++found;
+                const Layout::TAmount waste = WriteType(context, path + " (" + Report::GetTypeName(context.ast, elementType) + ")", elementType);
+
+                if (const clang::ConstantArrayType* arrayType = context.ast.getAsConstantArrayType(type))
+                {
+                    const Layout::TAmount count = static_cast<Layout::TAmount>(context.ast.getConstantArrayElementCount(arrayType));
+                    context.out << "      array of " << count << " elements, " << count * waste << " bytes wasted\n";
+                }
+            }
+
+            //alignment requested on the field itself
+            if (declAlign > typeAlign && offset > previousEnd)
+            {
+                ++found;
+                context.out << "    " << llvm::left_justify(path, 40) << "field alignment " << declAlign << " (type " << typeAlign << ") inserts " << (offset - previousEnd) << " bytes of padding before it\n";
+            }
+
+            previousEnd = offset + (field->isZeroSize(context.ast) ? 0 : context.ast.getTypeSizeInChars(type).getQuantity());
+
+            const clang::RecordDecl* record = type->getAsRecordDecl();
+            if (record && depth < MAX_DEPTH && !record->isInStdNamespace())
+            {
+                found += AnalyzeFields(context, record, path + '.', depth + 1);
+            }
+        }
+        return found;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context)
+    {
+        Report::WriteTitle(context, "Over-alignment");
+
+        unsigned int found = 0u;
+
+        const clang::QualType recordType = context.ast.getRecordType(context.declaration);
+        if (context.ast.getTypeAlignInChars(recordType).getQuantity() > Helpers::GetNaturalAlign(context.ast, recordType))
+        {
+            ++found;
+            WriteType(context, context.declaration->getNameAsString(), recordType);
+        }
+
+        found += AnalyzeFields(context, context.declaration, "", 0u);
+
+        if (found == 0u)
+        {
+            context.out << "  No over-aligned types found.\n";
+        }
+    }
+}
@@ -9,26 +9,59 @@
 #include <clang/AST/RecordLayout.h>
 #include <clang/Analysis/CFG.h>
 #include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/FileManager.h>
 #include <clang/Basic/LangOptions.h>
+#include <clang/Basic/SourceManager.h>
 #include <clang/Basic/TargetInfo.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Frontend/FrontendAction.h>
+#include <clang/Lex/Preprocessor.h>
+#include <clang/Serialization/PCHContainerOperations.h>
 #include <clang/Tooling/CommonOptionsParser.h>
 #include <clang/Tooling/Tooling.h>
 
 // LLVM includes
+#include <llvm/ADT/SmallString.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/xxhash.h>
 #include <iostream>
 
 #pragma warning(pop)    
 
+#include <algorithm>
+#include <thread>
 #include <unordered_map>
 
 #include "LayoutDefinitions.h"
 #include "IO.h"
+#include "ByValue.h"
+#include "Coalescing.h"
+#include "EmptyMembers.h"
+#include "EnumNarrowing.h"
+#include "FieldReorder.h"
+#include "Instantiation.h"
+#include "LayoutCache.h"
+#include "LayoutDatabase.h"
+#include "LayoutMatrix.h"
+#include "LockFree.h"
+#include "Misalignment.h"
+#include "OverAlignment.h"
+#include "RegisterPassing.h"
+#include "Relocation.h"
+#include "Report.h"
+#include "ResultCache.h"
+#include "SoAGenerator.h"
+#include "SumTypes.h"
+#include "TypeLookup.h"
+#include "UniqueRepresentation.h"
+#include "ZeroCopy.h"
 
 namespace ClangParser 
 {
@@ -38,11 +71,68 @@ namespace ClangParser
         unsigned int col;
     };
 
+    struct Options
+    {
+        Instantiation::TSpellings instantiations;
+        std::vector<std::string>  typeNames;
+
+        std::string           soaFilename;
+        unsigned int          soaVectorWidth;
+        FieldReorder::Params  reorder;
+
+        std::string           reportFilename;
+        bool                  coalescing;
+        Coalescing::Params    coalescingParams;
+        bool                  enumNarrowing;
+        bool                  sumTypes;
+        bool                  emptyMembers;
+        bool                  misaligned;
+        bool                  overAligned;
+        bool                  lockFree;
+        bool                  registerPassing;
+        bool                  relocation;
+        bool                  uniqueRepresentation;
+        bool                  zeroCopy;
+        bool                  byValue;
+        ByValue::Params       byValueParams;
+
+        ResultCache::Params   cache;
+    };
+
     using TFilenameLookup = std::unordered_map<unsigned int,size_t>; 
-    TFilenameLookup        g_filenameLookup;
 
-    Layout::Result         g_result;
+    // The records of one translation unit found by a project scan, with their own files
+    struct ScannedUnit
+    {
+        std::string                filename;
+        ResultCache::TDependencies dependencies;
+        std::vector<Layout::Node*> records;
+        Layout::TFiles             files;
+    };
+
+    // Everything a single parse produces, the parses of other targets or configurations run concurrently with their own
+    struct ParseState
+    {
+        Layout::Result  result;
+        TFilenameLookup filenameLookup;
+        bool            isMain = true; //only the main parse runs the generators, rewrites and reports
+        bool            isScan = false; //computes every record of each translation unit into units instead
+
+        std::vector<ScannedUnit> units;
+
+        bool hasActionFailed = false; //a generator or a rewrite could not produce its output
+
+        bool                   useLayoutCache = false; //share the computed layouts between translation units
+        LayoutCache::UnitState layoutCacheState;
+
+        ResultCache::TDependencies dependencies; //only collected when caching
+        std::vector<Layout::Node*> queries; //one per instantiation spelling then per type name, null when it could not be resolved
+    };
+
+    ParseState             g_state;
+    LayoutCache::Cache     g_layoutCache;
     LocationFilter         g_locationFilter;
+    Options                g_options;
 
     namespace Helpers
     {
@@ -59,26 +149,53 @@ namespace ClangParser
             }
         }
 
-        void ClearResult()
+        void ClearResult(ParseState& state)
         { 
-            g_filenameLookup.clear();
-            Helpers::DestroyTree(ClangParser::g_result.node);
-            g_result.node = nullptr;
-            g_result.files.clear();
+            state.filenameLookup.clear();
+            Helpers::DestroyTree(state.result.node);
+            state.result.node = nullptr;
+            state.result.files.clear();
+            state.dependencies.clear();
+            state.hasActionFailed = false;
+            state.layoutCacheState = LayoutCache::UnitState();
+
+            for (Layout::Node* node : state.queries)
+            {
+                Helpers::DestroyTree(node);
+            }
+            state.queries.clear();
+
+            for (ScannedUnit& unit : state.units)
+            {
+                for (Layout::Node* node : unit.records)
+                {
+                    Helpers::DestroyTree(node);
+                }
+            }
+            state.units.clear();
         }
 
-        size_t AddFileToDictionary(const clang::FileID fileId, const char* filename)
+        size_t AddFileToDictionary(ParseState& state, const clang::FileID fileId, const char* filename)
         {
-            const size_t nextIndex = g_result.files.size();
-            std::pair<TFilenameLookup::iterator,bool> const& result = g_filenameLookup.insert(TFilenameLookup::value_type(fileId.getHashValue(),nextIndex));
+            const size_t nextIndex = state.result.files.size();
+            std::pair<TFilenameLookup::iterator,bool> const& result = state.filenameLookup.insert(TFilenameLookup::value_type(fileId.getHashValue(),nextIndex));
             if (result.second) 
             { 
-                g_result.files.emplace_back(filename);
+                //layouts from the cache or from other translation units might have added the file already
+                const Layout::TFiles::const_iterator found = std::find(state.result.files.begin(), state.result.files.end(), filename);
+                if (found != state.result.files.end())
+                {
+                    result.first->second = found - state.result.files.begin();
+                }
+                else
+                {
+                    state.result.files.emplace_back(filename);
+                }
             } 
             return result.first->second;
         }
 
-        void RetrieveLocation(Layout::Location& output, const clang::ASTContext& context, const clang::SourceLocation& location)
+        void RetrieveLocation(ParseState& state, Layout::Location& output, const clang::ASTContext& context, const clang::SourceLocation& location)
         { 
             const clang::SourceManager& sourceManager = context.getSourceManager();
 
@@ -89,16 +206,46 @@ namespace ClangParser
 
             if (!startLocation.isValid() || !fileId.isValid()) return;
 
-            output.fileIndex = static_cast<int>(AddFileToDictionary(fileId, startLocation.getFilename()));
+            output.fileIndex = static_cast<int>(AddFileToDictionary(state, fileId, startLocation.getFilename()));
             output.line      = startLocation.getLine();
             output.column    = startLocation.getColumn();
         }
 
-        Layout::Node* ComputeStruct(const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const bool includeVirtualBases = true)
+        bool HasRecordReports()
+        { 
+            return g_options.coalescing || g_options.enumNarrowing || g_options.sumTypes || g_options.emptyMembers || g_options.misaligned || g_options.overAligned || g_options.lockFree || g_options.registerPassing || g_options.relocation || g_options.uniqueRepresentation || g_options.zeroCopy;
+        }
+
+        bool HasReports()
+        { 
+            return HasRecordReports() || g_options.byValue;
+        }
+
+        bool OpenReportFile(std::unique_ptr<llvm::raw_fd_ostream>& output, const bool append)
+        { 
+            if (g_options.reportFilename.empty())
+            {
+                return true;
+            }
+
+            std::error_code errorCode;
+            output = std::make_unique<llvm::raw_fd_ostream>(g_options.reportFilename, errorCode, append ? llvm::sys::fs::OF_Append | llvm::sys::fs::OF_Text : llvm::sys::fs::OF_Text);
+            if (errorCode)
+            {
+                LOG_ERROR("Unable to open '%s' for writing: %s", g_options.reportFilename.c_str(), errorCode.message().c_str());
+                output.reset();
+                return false;
+            }
+            return true;
+        }
+
+        Layout::Node* ComputeCachedStruct(ParseState& state, const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const bool includeVirtualBases = true);
+
+        Layout::Node* ComputeStruct(ParseState& state, const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const bool includeVirtualBases = true)
         {
             Layout::Node* node = new Layout::Node();
 
-            RetrieveLocation(node->typeLocation,context,declaration->getLocation());
+            RetrieveLocation(state,node->typeLocation,context,declaration->getLocation());
 
             const clang::ASTRecordLayout& layout = context.getASTRecordLayout(declaration);
 
@@ -150,7 +297,7 @@ namespace ClangParser
             // compute nvbases
             for(const clang::CXXRecordDecl* base : bases)
             {
-                Layout::Node* baseNode = ComputeStruct(context,base,false); 
+                Layout::Node* baseNode = ComputeCachedStruct(state,context,base,false); 
                 baseNode->offset = layout.getBaseClassOffset(base).getQuantity();
                 baseNode->nature = base == primaryBase? Layout::Category::NVPrimaryBase : Layout::Category::NVBase;
                 node->children.push_back(baseNode);
@@ -179,13 +326,13 @@ namespace ClangParser
                 // Recursively visit fields of record type.
                 if (const clang::CXXRecordDecl* fieldDeclarationCXX = field.getType()->getAsCXXRecordDecl())
                 {
-                    Layout::Node* fieldNode = ComputeStruct(context,fieldDeclarationCXX,true);
+                    Layout::Node* fieldNode = ComputeCachedStruct(state,context,fieldDeclarationCXX,true);
                     fieldNode->name   = field.getNameAsString();
                     fieldNode->type   = field.getType().getAsString(); //check if this or qualified types form function is better
                     fieldNode->offset = fieldOffset.getQuantity();
                     fieldNode->nature = Layout::Category::ComplexField;
 
-                    RetrieveLocation(fieldNode->fieldLocation,context,field.getLocation());
+                    RetrieveLocation(state,fieldNode->fieldLocation,context,field.getLocation());
 
                     node->children.push_back(fieldNode);
                 }
@@ -226,7 +373,7 @@ namespace ClangParser
                         fieldNode->size   = context.toCharUnitsFromBits(fieldInfo.Width).getQuantity();
                         fieldNode->align  = context.toCharUnitsFromBits(fieldInfo.Align).getQuantity();
 
-                        RetrieveLocation(fieldNode->fieldLocation,context,field.getLocation());
+                        RetrieveLocation(state,fieldNode->fieldLocation,context,field.getLocation());
 
                         node->children.push_back(fieldNode);
                     }
@@ -256,7 +403,7 @@ namespace ClangParser
                         node->children.push_back(vtorDispNode);
                     }
 
-                    Layout::Node* vBaseNode = ComputeStruct(context,vBase,false);
+                    Layout::Node* vBaseNode = ComputeCachedStruct(state,context,vBase,false);
                     vBaseNode->offset = vBaseOffset.getQuantity();
                     vBaseNode->nature = vBase == primaryBase? Layout::Category::VPrimaryBase : Layout::Category::VBase;
                     node->children.push_back(vBaseNode);
@@ -265,6 +412,25 @@ namespace ClangParser
 
             return node;
         }
+
+        Layout::Node* ComputeCachedStruct(ParseState& state, const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const bool includeVirtualBases)
+        {
+            if (!state.useLayoutCache)
+            {
+                return ComputeStruct(state, context, declaration, includeVirtualBases);
+            }
+
+            //callers patch the name, offset and nature of the returned copy, the cached one stays untouched
+            const uint64_t key = LayoutCache::ComputeKey(context, state.layoutCacheState, declaration, includeVirtualBases);
+            if (Layout::Node* node = g_layoutCache.Fetch(state.result.files, key))
+            {
+                return node;
+            }
+
+            Layout::Node* node = ComputeStruct(state, context, declaration, includeVirtualBases);
+            g_layoutCache.Store(key, *node, state.result.files);
+            return node;
+        }
     }
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -333,32 +499,239 @@ namespace ClangParser
         unsigned int m_bestStartCol; 
     };
 
+    class RecordCollectorVisitor : public clang::RecursiveASTVisitor<RecordCollectorVisitor> 
+    {
+    public:
+        RecordCollectorVisitor(const clang::SourceManager& sourceManager)
+            : m_sourceManager(sourceManager)
+        {}
+
+        bool VisitCXXRecordDecl(clang::CXXRecordDecl* declaration) 
+        {
+            //named records defined in the project, the implicit template instantiations only show up as fields
+            if (declaration->isThisDeclarationADefinition() && declaration->isCompleteDefinition() && !declaration->isDependentType() && !declaration->isInvalidDecl() && !declaration->isLambda() && 
+                (declaration->getIdentifier() || declaration->getTypedefNameForAnonDecl()) && !m_sourceManager.isInSystemHeader(declaration->getLocation()))
+            { 
+                m_records.push_back(declaration);
+            }
+            return true;
+        }
+
+        const std::vector<const clang::CXXRecordDecl*>& GetRecords() const { return m_records; }
+
+    private:
+        const clang::SourceManager&              m_sourceManager;
+        std::vector<const clang::CXXRecordDecl*> m_records;
+    };
+
     class Consumer : public clang::ASTConsumer 
     {
+        void RunReports(clang::ASTContext& context, const clang::CXXRecordDecl* declaration)
+        { 
+            std::unique_ptr<llvm::raw_fd_ostream> file;
+            if (!Helpers::OpenReportFile(file, false))
+            {
+                return;
+            }
+
+            llvm::raw_ostream& out = file ? *file : llvm::outs();
+
+            if (declaration && Helpers::HasRecordReports())
+            {
+                const Report::Context reportContext{ context, declaration, m_state.result, out };
+
+                if (g_options.coalescing)           Coalescing::Analyze(reportContext, g_options.coalescingParams);
+                if (g_options.enumNarrowing)        EnumNarrowing::Analyze(reportContext);
+                if (g_options.sumTypes)             SumTypes::Analyze(reportContext);
+                if (g_options.emptyMembers)         EmptyMembers::Analyze(reportContext);
+                if (g_options.misaligned)           Misalignment::Analyze(reportContext);
+                if (g_options.overAligned)          OverAlignment::Analyze(reportContext);
+                if (g_options.lockFree)             LockFree::Analyze(reportContext);
+                if (g_options.registerPassing)      RegisterPassing::Analyze(reportContext, m_compiler);
+                if (g_options.relocation)           Relocation::Analyze(reportContext, m_compiler.getSema());
+                if (g_options.uniqueRepresentation) UniqueRepresentation::Analyze(reportContext);
+                if (g_options.zeroCopy)             ZeroCopy::Analyze(reportContext);
+            }
+
+            if (g_options.byValue)
+            {
+                ByValue::Analyze(context, out, g_options.byValueParams);
+            }
+        }
+
+        void ComputeQueries(clang::ASTContext& context)
+        { 
+            //the first translation unit resolving a query provides its layout
+            const size_t numInstantiations = g_options.instantiations.size();
+            m_state.queries.resize(numInstantiations + g_options.typeNames.size(), nullptr);
+
+            Instantiation::TRecords records;
+            if (numInstantiations > 0)
+            {
+                Instantiation::Resolve(records, m_compiler.getSema(), g_options.instantiations);
+            }
+
+            for (size_t i = 0; i < g_options.typeNames.size(); ++i)
+            {
+                records.push_back(m_state.queries[numInstantiations + i] ? nullptr : TypeLookup::Find(m_compiler.getSema(), g_options.typeNames[i]));
+            }
+
+            for (size_t i = 0; i < records.size(); ++i)
+            {
+                if (m_state.queries[i] || !records[i])
+                {
+                    continue;
+                }
+
+                //keep the template arguments to tell the specializations apart
+                Layout::Node* node = Helpers::ComputeCachedStruct(m_state, context, records[i]);
+                node->type = Report::GetTypeName(context, context.getRecordType(records[i]));
+                m_state.queries[i] = node;
+            }
+        }
+
+        void ScanUnit(clang::ASTContext& context)
+        { 
+            const clang::SourceManager& sourceManager = context.getSourceManager();
+
+            ScannedUnit unit;
+            if (clang::OptionalFileEntryRef mainFile = sourceManager.getFileEntryRefForID(sourceManager.getMainFileID()))
+            {
+                llvm::SmallString<256> path(mainFile->getName());
+                sourceManager.getFileManager().makeAbsolutePath(path);
+                llvm::sys::path::remove_dots(path, true);
+                unit.filename = path.str().str();
+            }
+
+            ResultCache::CollectDependencies(unit.dependencies, sourceManager);
+
+            RecordCollectorVisitor visitor(sourceManager);
+            visitor.TraverseDecl(context.getTranslationUnitDecl());
+
+            //every unit gets its own files so it can be replaced on its own
+            m_state.result.files.clear();
+            for (const clang::CXXRecordDecl* declaration : visitor.GetRecords())
+            {
+                Layout::Node* node = Helpers::ComputeCachedStruct(m_state, context, declaration);
+                node->type = Report::GetTypeName(context, context.getRecordType(declaration));
+                unit.records.push_back(node);
+            }
+
+            unit.files = std::move(m_state.result.files);
+            m_state.result.files.clear();
+            m_state.units.push_back(std::move(unit));
+        }
+
+        void RunActions(clang::ASTContext& context, const clang::CXXRecordDecl* declaration)
+        { 
+            if (declaration && !g_options.soaFilename.empty())
+            {
+                m_state.hasActionFailed |= !SoAGenerator::Generate(context, declaration, *m_state.result.node, g_options.soaVectorWidth, g_options.soaFilename.c_str());
+            }
+
+            if (declaration && (!g_options.reorder.diffFilename.empty() || g_options.reorder.inPlace))
+            {
+                m_state.hasActionFailed |= !FieldReorder::Apply(context, declaration, g_options.reorder);
+            }
+
+            if (Helpers::HasReports())
+            {
+                RunReports(context, declaration);
+            }
+        }
+
     public:
+        Consumer(clang::CompilerInstance& compiler, ParseState& state)
+            : m_compiler(compiler)
+            , m_state(state)
+        {}
+
         virtual void HandleTranslationUnit(clang::ASTContext& context) override
         {
+            if (m_state.isScan)
+            {
+                //error recovered layouts stay out of the database, the unit is not stored so the next update parses it again
+                if (m_compiler.getDiagnostics().hasErrorOccurred())
+                {
+                    LOG_ERROR("Skipping the records of '%s', it failed to compile", m_compiler.getFrontendOpts().Inputs.empty() ? "<unknown>" : m_compiler.getFrontendOpts().Inputs[0].getFile().str().c_str());
+                    return;
+                }
+
+                ScanUnit(context);
+                return;
+            }
+
             const clang::SourceManager& sourceManager = context.getSourceManager();
             auto Decls = context.getTranslationUnitDecl()->decls();
 
+            //named queries go through Sema lookup, only walk the tree when a location was requested
             FindStructAtLocationVisitor visitor(sourceManager);
-            for (auto& Decl : Decls) 
+            if (g_locationFilter.row != 0u)
             {
-                visitor.TraverseDecl(Decl);
+                for (auto& Decl : Decls) 
+                {
+                    visitor.TraverseDecl(Decl);
+                }
             }
 
             if (const clang::CXXRecordDecl* best = visitor.GetBest())
             {
-                g_result.node = Helpers::ComputeStruct(context, best);
+                m_state.result.node = Helpers::ComputeCachedStruct(m_state, context, best);
+            }
+
+            if (m_state.isMain && !g_options.cache.directory.empty())
+            {
+                ResultCache::CollectDependencies(m_state.dependencies, sourceManager);
+            }
+
+            if (m_state.isMain)
+            {
+                ComputeQueries(context);
+                RunActions(context, visitor.GetBest());
             }
         }
+
+    private:
+        clang::CompilerInstance& m_compiler;
+        ParseState&              m_state;
     };
 
     class Action : public clang::ASTFrontendAction 
     {
     public:
+        Action(ParseState& state)
+            : m_state(state)
+        {}
+
         using ASTConsumerPointer = std::unique_ptr<clang::ASTConsumer>;
-        ASTConsumerPointer CreateASTConsumer(clang::CompilerInstance&, llvm::StringRef) override { return std::make_unique<Consumer>(); }
+        ASTConsumerPointer CreateASTConsumer(clang::CompilerInstance& compiler, llvm::StringRef) override 
+        { 
+            //file ids are only unique within a translation unit
+            m_state.filenameLookup.clear();
+
+            if (m_state.useLayoutCache)
+            {
+                m_state.layoutCacheState = LayoutCache::UnitState();
+                compiler.getPreprocessor().addPPCallbacks(LayoutCache::CreateMacroRecorder(m_state.layoutCacheState, compiler.getPreprocessor()));
+            }
+            return std::make_unique<Consumer>(compiler, m_state); 
+        }
+
+    private:
+        ParseState& m_state;
+    };
+
+    class ActionFactory : public clang::tooling::FrontendActionFactory 
+    {
+    public:
+        ActionFactory(ParseState& state)
+            : m_state(state)
+        {}
+
+        std::unique_ptr<clang::FrontendAction> create() override { return std::make_unique<Action>(m_state); }
+
+    private:
+        ParseState& m_state;
     };
 }
 
@@ -371,6 +744,36 @@ namespace CommandLine
     llvm::cl::opt<std::string>  g_outputFilename("output", llvm::cl::desc("Specify output filename"), llvm::cl::value_desc("filename"), llvm::cl::cat(g_commandLineCategory));
     llvm::cl::opt<unsigned int> g_locationRow("locationRow", llvm::cl::desc("Specify input filename row to inspect"), llvm::cl::value_desc("number"), llvm::cl::cat(g_commandLineCategory));
     llvm::cl::opt<unsigned int> g_locationCol("locationCol", llvm::cl::desc("Specify input filename column to inspect"), llvm::cl::value_desc("number"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<std::string>  g_soaFilename("soa", llvm::cl::desc("Generate a structure-of-arrays container header for the found record"), llvm::cl::value_desc("filename"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<unsigned int> g_soaVectorWidth("soaVectorWidth", llvm::cl::desc("Alignment and padding in bytes of each generated SoA array (64 by default)"), llvm::cl::value_desc("bytes"), llvm::cl::init(64u), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<std::string>  g_reorderDiff("reorder", llvm::cl::desc("Reorder the found record fields and write the source changes as a unified diff"), llvm::cl::value_desc("filename"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_reorderInPlace("reorderInPlace", llvm::cl::desc("Write the reordered fields back to the source files"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::list<std::string> g_fieldOrder("fieldOrder", llvm::cl::desc("Field order to apply when reordering (sorted by alignment by default)"), llvm::cl::value_desc("name,name,..."), llvm::cl::CommaSeparated, llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<std::string>  g_reportFilename("report", llvm::cl::desc("Specify the analysis report filename (stdout by default)"), llvm::cl::value_desc("filename"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_coalescing("coalescing", llvm::cl::desc("Report bools, small enums, small range integers and bitfields that could share a storage unit"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::list<std::string> g_coalescingExclude("coalescingExclude", llvm::cl::desc("Fields written from multiple threads that must not be coalesced"), llvm::cl::value_desc("name,name,..."), llvm::cl::CommaSeparated, llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::list<std::string> g_coalescingRange("coalescingRange", llvm::cl::desc("Value range of an integer field, it becomes a coalescing candidate when the range needs fewer bits than its type"), llvm::cl::value_desc("name:min:max,..."), llvm::cl::CommaSeparated, llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_enumNarrowing("enumNarrowing", llvm::cl::desc("Report enum fields whose underlying type is wider than their enumerators need"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_sumTypes("sumTypes", llvm::cl::desc("Report the size overhead of std::variant, std::optional and union fields"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_emptyMembers("emptyMembers", llvm::cl::desc("Report empty member fields that could be empty bases or [[no_unique_address]]"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_misaligned("misaligned", llvm::cl::desc("Report fields placed at offsets that break their natural alignment or split a cache line"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_overAligned("overAligned", llvm::cl::desc("Report over-aligned records and fields with their array waste and aligned new usage"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_lockFree("lockFree", llvm::cl::desc("Report std::atomic and std::atomic_ref target fields that are not always lock-free on the target"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_registerPassing("registerPassing", llvm::cl::desc("Report whether the record is passed and returned in registers on the target and what prevents it"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_relocation("relocation", llvm::cl::desc("Report trivial copyability, trivial destruction and nothrow move construction of the record and its subobjects"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_uniqueRepresentation("uniqueRepresentation", llvm::cl::desc("Report whether the record has unique object representations and which padding or fields prevent it"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_zeroCopy("zeroCopy", llvm::cl::desc("Report whether the record can be memory mapped or shared between processes as is"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<bool>         g_byValue("byValue", llvm::cl::desc("Report the record parameters and return values passed by value by the functions of the main file"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<unsigned int> g_byValueThreshold("byValueThreshold", llvm::cl::desc("Size above which a record passed by value is flagged (64 by default)"), llvm::cl::value_desc("bytes"), llvm::cl::init(64u), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::list<std::string> g_targets("targets", llvm::cl::desc("Target triples to compare the found record layout across, parsed in parallel"), llvm::cl::value_desc("triple,triple,..."), llvm::cl::CommaSeparated, llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::list<std::string> g_instantiations("instantiate", llvm::cl::desc("Type spelling of a template specialization to instantiate and compute, written next to the output as <output>.<n>.slbin (repeatable)"), llvm::cl::value_desc("type"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::list<std::string> g_typeNames("type", llvm::cl::desc("Qualified name of a record to compute, written next to the output as <output>.<n>.slbin after the instantiations (repeatable)"), llvm::cl::value_desc("ns::name"), llvm::cl::CommaSeparated, llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<std::string>  g_cacheDirectory("cache", llvm::cl::desc("Directory of the result cache, the stored result is reused while the sources, their includes, the flags and the location are unchanged"), llvm::cl::value_desc("directory"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<unsigned int> g_cacheSize("cacheSize", llvm::cl::desc("Size limit of the result cache, least recently used results are evicted first (256 by default)"), llvm::cl::value_desc("MB"), llvm::cl::init(256u), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<std::string>  g_projectFilename("project", llvm::cl::desc("Project layout database to update with every record of the sources, only the translation units whose flags, sources or includes changed are parsed again (whole compilation database when no sources are given)"), llvm::cl::value_desc("filename"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<std::string>  g_shard("shard", llvm::cl::desc("Only the translation units of the given shard go into the project database so each shard can run in its own process, LayoutQuery -merge combines the shard databases"), llvm::cl::value_desc("index/count"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::opt<unsigned int> g_jobs("jobs", llvm::cl::desc("Number of translation units parsed in parallel when updating the project database (hardware threads by default)"), llvm::cl::value_desc("number"), llvm::cl::cat(g_commandLineCategory));
+    llvm::cl::list<std::string> g_configs("config", llvm::cl::desc("Named set of extra compile flags to compare the found record layout across, parsed in parallel (repeatable)"), llvm::cl::value_desc("name:flags"), llvm::cl::cat(g_commandLineCategory));
 
     //aliases
     llvm::cl::alias g_shortOutputFilenameOption("o", llvm::cl::desc("Alias for -output"), llvm::cl::aliasopt(g_outputFilename));
@@ -385,32 +788,518 @@ namespace Parser
         ClangParser::g_locationFilter = filter;
     }
 
+    void SetOptions(const ClangParser::Options& options)
+    { 
+        ClangParser::g_options = options;
+    }
+
+    ClangParser::Options GatherOptions()
+    { 
+        ClangParser::Options options;
+        options.instantiations.assign(CommandLine::g_instantiations.begin(), CommandLine::g_instantiations.end());
+        options.typeNames.assign(CommandLine::g_typeNames.begin(), CommandLine::g_typeNames.end());
+        options.soaFilename          = CommandLine::g_soaFilename;
+        options.soaVectorWidth       = CommandLine::g_soaVectorWidth;
+        options.reorder.diffFilename = CommandLine::g_reorderDiff;
+        options.reorder.inPlace      = CommandLine::g_reorderInPlace;
+        options.reorder.fieldOrder.assign(CommandLine::g_fieldOrder.begin(), CommandLine::g_fieldOrder.end());
+        options.reportFilename       = CommandLine::g_reportFilename;
+        options.coalescing           = CommandLine::g_coalescing;
+        options.coalescingParams.excluded.assign(CommandLine::g_coalescingExclude.begin(), CommandLine::g_coalescingExclude.end());
+        options.coalescingParams.ranges.assign(CommandLine::g_coalescingRange.begin(), CommandLine::g_coalescingRange.end());
+        options.enumNarrowing        = CommandLine::g_enumNarrowing;
+        options.sumTypes             = CommandLine::g_sumTypes;
+        options.emptyMembers         = CommandLine::g_emptyMembers;
+        options.misaligned           = CommandLine::g_misaligned;
+        options.overAligned          = CommandLine::g_overAligned;
+        options.lockFree             = CommandLine::g_lockFree;
+        options.registerPassing      = CommandLine::g_registerPassing;
+        options.relocation           = CommandLine::g_relocation;
+        options.uniqueRepresentation = CommandLine::g_uniqueRepresentation;
+        options.zeroCopy             = CommandLine::g_zeroCopy;
+        options.byValue              = CommandLine::g_byValue;
+        options.byValueParams.threshold = CommandLine::g_byValueThreshold;
+        options.cache.directory      = CommandLine::g_cacheDirectory;
+        options.cache.sizeLimitMB    = CommandLine::g_cacheSize;
+        return options;
+    }
+
+    // An extra parse of the same sources with adjusted compile arguments
+    struct Variant
+    {
+        std::string                       name;
+        clang::tooling::ArgumentsAdjuster adjuster;
+    };
+
+    using TVariants = std::vector<Variant>;
+
+    clang::tooling::ArgumentsAdjuster GetTargetAdjuster(const std::string& triple)
+    {
+        return [triple](const clang::tooling::CommandLineArguments& arguments, llvm::StringRef)
+        {
+            //replace whatever target or bitness the compile command asks for
+            clang::tooling::CommandLineArguments output;
+            for (size_t i = 0; i < arguments.size(); ++i)
+            {
+                const llvm::StringRef argument = arguments[i];
+                if (argument == "-target" || argument == "--target")
+                {
+                    ++i;
+                    continue;
+                }
+
+                if (argument == "-m32" || argument == "-m64" || argument.starts_with("--target=") || argument.starts_with("-target="))
+                {
+                    continue;
+                }
+
+                output.push_back(arguments[i]);
+                if (i == 0)
+                {
+                    output.push_back("--target=" + triple);
+                }
+            }
+            return output;
+        };
+    }
+
+    Variant GetConfigVariant(const std::string& config)
+    {
+        //'Debug:-D_DEBUG -D_ITERATOR_DEBUG_LEVEL=2', the whole text names the variant when there is no name
+        const std::pair<llvm::StringRef, llvm::StringRef> parts = llvm::StringRef(config).split(':');
+        const llvm::StringRef flags = llvm::StringRef(config).contains(':') ? parts.second : parts.first;
+
+        llvm::SmallVector<llvm::StringRef, 8> pieces;
+        flags.split(pieces, ' ', -1, false);
+
+        clang::tooling::CommandLineArguments arguments;
+        for (const llvm::StringRef piece : pieces)
+        {
+            arguments.push_back(piece.str());
+        }
+
+        //appended so they override the flags of the compile command
+        return Variant{ parts.first.str(), clang::tooling::getInsertArgumentAdjuster(arguments, clang::tooling::ArgumentInsertPosition::END) };
+    }
+
+    using TVirtualFiles = std::vector<std::pair<std::string, std::string>>;
+
+    bool InjectInstantiations(clang::tooling::ClangTool& tool, TVirtualFiles& virtualFiles, const std::vector<std::string>& sources, const Instantiation::TSpellings& spellings)
+    {
+        //the tool only keeps references to the mapped paths and contents, they need to outlive the run
+        const std::string injected = Instantiation::GetInjectedSource(spellings);
+        virtualFiles.reserve(sources.size());
+
+        for (const std::string& source : sources)
+        {
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(source);
+            if (!buffer)
+            {
+                LOG_ERROR("Unable to read '%s': %s", source.c_str(), buffer.getError().message().c_str());
+                return false;
+            }
+
+            virtualFiles.emplace_back(clang::tooling::getAbsolutePath(source), (*buffer)->getBuffer().str() + injected);
+            tool.mapVirtualFile(virtualFiles.back().first, virtualFiles.back().second);
+        }
+        return true;
+    }
+
+    bool WriteQueries(const ClangParser::ParseState& state, const char* outputFileName)
+    {
+        bool ret = true;
+        for (size_t i = 0; i < state.queries.size(); ++i)
+        {
+            if (Layout::Node* node = state.queries[i])
+            {
+                llvm::SmallString<256> fileName(outputFileName);
+                llvm::sys::path::replace_extension(fileName, std::to_string(i + 1) + llvm::sys::path::extension(outputFileName).str());
+
+                Layout::Result result;
+                result.node  = node;
+                result.files = state.result.files;
+                ret = IO::ToFile(result, fileName.c_str()) && ret;
+
+                LOG_INFO("%s -> %s", node->type.c_str(), fileName.c_str());
+            }
+            else
+            {
+                //no translation unit resolved it, the error was logged during the parse
+                ret = false;
+            }
+        }
+        return ret;
+    }
+
+    bool ParseVariants(const clang::tooling::CompilationDatabase& compilations, const std::vector<std::string>& sources, const TVariants& variants, const char* title, const bool append)
+    {
+        //each variant gets its own tool and parse state so they can run in parallel
+        std::vector<ClangParser::ParseState> states(variants.size());
+        std::vector<int> retCodes(variants.size(), 0);
+        std::vector<std::thread> threads;
+
+        for (size_t i = 0; i < variants.size(); ++i)
+        {
+            states[i].isMain = false;
+            states[i].useLayoutCache = sources.size() > 1;
+            threads.emplace_back([&compilations, &sources, &variants, &states, &retCodes, i]()
+            {
+                //a tool on the real file system changes the process working directory to each compile command directory, the threads would race on it
+                clang::tooling::ClangTool tool(compilations, sources, std::make_shared<clang::PCHContainerOperations>(), llvm::vfs::createPhysicalFileSystem());
+                tool.appendArgumentsAdjuster(variants[i].adjuster);
+
+                ClangParser::ActionFactory factory(states[i]);
+                retCodes[i] = tool.run(&factory);
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        //a variant that failed to parse has no layout or a partial one, its column is left out rather than compared
+        bool ret = true;
+        LayoutMatrix::TColumns columns;
+        for (size_t i = 0; i < variants.size(); ++i)
+        {
+            if (retCodes[i] != 0)
+            {
+                LOG_ERROR("Unable to parse the sources for %s, it is left out of the comparison", variants[i].name.c_str());
+                ret = false;
+                continue;
+            }
+            columns.push_back(LayoutMatrix::Column{ variants[i].name, states[i].result.node });
+        }
+
+        std::unique_ptr<llvm::raw_fd_ostream> file;
+        if (ClangParser::Helpers::OpenReportFile(file, append))
+        {
+            LayoutMatrix::Write(file ? *file : llvm::outs(), title, columns);
+        }
+        else
+        {
+            ret = false;
+        }
+
+        for (ClangParser::ParseState& state : states)
+        {
+            ClangParser::Helpers::ClearResult(state);
+        }
+
+        return ret;
+    }
+
+    std::string GetCanonicalPath(const std::string& filename)
+    {
+        llvm::SmallString<256> path(clang::tooling::getAbsolutePath(filename));
+        llvm::sys::path::remove_dots(path, true);
+        return path.str().str();
+    }
+
+    struct Shard
+    {
+        unsigned int index;
+        unsigned int count;
+    };
+
+    bool GetShard(Shard& output, const std::string& text)
+    {
+        output = Shard{ 0u, 1u };
+        if (text.empty())
+        {
+            return true;
+        }
+
+        //getAsInteger returns true on failure
+        const llvm::StringRef value(text);
+        const std::pair<llvm::StringRef, llvm::StringRef> parts = value.split('/');
+        return !parts.first.getAsInteger(10, output.index) && !parts.second.getAsInteger(10, output.count) && output.count > 0u && output.index < output.count;
+    }
+
+    bool IsInShard(const Shard& shard, const std::string& filename)
+    {
+        //by path hash rather than list position so a unit stays in its shard when sources are added or removed
+        return shard.count <= 1u || llvm::xxHash64(filename) % shard.count == shard.index;
+    }
+
+    bool ParseProject(const clang::tooling::CompilationDatabase& compilations, const std::vector<std::string>& sourcePaths, const char* databaseFilename)
+    {
+        Shard shard;
+        if (!GetShard(shard, CommandLine::g_shard))
+        {
+            LOG_ERROR("Invalid shard '%s', expected 'index/count' with the index below the count", CommandLine::g_shard.c_str());
+            return false;
+        }
+
+        //without sources the whole compilation database is the project and the units no longer in it are dropped
+        const bool isWholeProject = sourcePaths.empty();
+        std::vector<std::string> sources = isWholeProject ? compilations.getAllFiles() : sourcePaths;
+        for (std::string& source : sources)
+        {
+            source = GetCanonicalPath(source);
+        }
+        std::sort(sources.begin(), sources.end());
+        sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+        sources.erase(std::remove_if(sources.begin(), sources.end(), [&shard](const std::string& source) { return !IsInShard(shard, source); }), sources.end());
+
+        LayoutDatabase::Database database;
+        const bool isNew = !llvm::sys::fs::exists(databaseFilename);
+        if (!isNew && !LayoutDatabase::FromFile(database, databaseFilename))
+        {
+            LOG_WARNING("Unable to read the project database '%s', rebuilding it", databaseFilename);
+        }
+
+        std::unordered_map<std::string, size_t> unitIndices;
+        for (size_t i = 0; i < database.units.size(); ++i)
+        {
+            unitIndices.emplace(database.units[i].filename, i);
+        }
+
+        //a unit is parsed again when its flags, its main file or any of its includes changed, the others keep their records
+        ResultCache::TFileHashes hashes;
+        std::vector<bool> isRemoved(database.units.size(), isWholeProject);
+        for (size_t i = 0; i < database.units.size(); ++i)
+        {
+            isRemoved[i] = isRemoved[i] || !IsInShard(shard, database.units[i].filename);
+        }
+        std::vector<std::string> changed;
+        size_t numOutdated = 0u;
+        for (const std::string& source : sources)
+        {
+            const std::unordered_map<std::string, size_t>::const_iterator found = unitIndices.find(source);
+            if (found != unitIndices.end())
+            {
+                const LayoutDatabase::Unit& unit = database.units[found->second];
+                const bool isUpToDate = unit.commandHash == ResultCache::HashCompileCommand(compilations, source) && ResultCache::IsUpToDate(unit.dependencies, hashes);
+                isRemoved[found->second] = !isUpToDate;
+                if (isUpToDate)
+                {
+                    continue;
+                }
+                ++numOutdated;
+            }
+            changed.push_back(source);
+        }
+
+        const size_t numRemoved = std::count(isRemoved.begin(), isRemoved.end(), true);
+        LayoutDatabase::RemoveUnits(database, isRemoved);
+
+        LOG_PROGRESS("Project: %zu of %zu translation units to parse, %zu dropped", changed.size(), sources.size(), numRemoved - numOutdated);
+        if (changed.empty() && numRemoved == 0u && !isNew)
+        {
+            LayoutDatabase::Clear(database);
+            return true;
+        }
+
+        //each job parses its share of the units with its own tool, the layouts of the shared headers are computed once for all of them
+        const unsigned int requestedJobs = CommandLine::g_jobs > 0u ? CommandLine::g_jobs : std::max(1u, std::thread::hardware_concurrency());
+        const size_t numJobs = std::max<size_t>(1u, std::min<size_t>(changed.size(), requestedJobs));
+
+        std::vector<ClangParser::ParseState> states(numJobs);
+        std::vector<int> retCodes(numJobs, 0);
+        std::vector<std::thread> threads;
+
+        for (size_t i = 0; i < numJobs; ++i)
+        {
+            states[i].isMain = false;
+            states[i].isScan = true;
+            states[i].useLayoutCache = true;
+            threads.emplace_back([&compilations, &changed, &states, &retCodes, numJobs, i]()
+            {
+                std::vector<std::string> jobSources;
+                for (size_t j = i; j < changed.size(); j += numJobs)
+                {
+                    jobSources.push_back(changed[j]);
+                }
+
+                //own file system per job so the compile command directories do not race on the process working directory
+                clang::tooling::ClangTool tool(compilations, jobSources, std::make_shared<clang::PCHContainerOperations>(), llvm::vfs::createPhysicalFileSystem());
+                ClangParser::ActionFactory factory(states[i]);
+                retCodes[i] = tool.run(&factory);
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        //merge in filename order so the database does not depend on the number of jobs
+        std::vector<ClangParser::ScannedUnit*> scanned;
+        for (ClangParser::ParseState& state : states)
+        {
+            for (ClangParser::ScannedUnit& unit : state.units)
+            {
+                scanned.push_back(&unit);
+            }
+        }
+        std::sort(scanned.begin(), scanned.end(), [](const ClangParser::ScannedUnit* a, const ClangParser::ScannedUnit* b) { return a->filename < b->filename; });
+
+        for (ClangParser::ScannedUnit* scannedUnit : scanned)
+        {
+            LayoutDatabase::Unit unit;
+            unit.filename     = scannedUnit->filename;
+            unit.commandHash  = ResultCache::HashCompileCommand(compilations, scannedUnit->filename);
+            unit.dependencies = scannedUnit->dependencies;
+
+            const unsigned int unitIndex = LayoutDatabase::AddUnit(database, unit);
+            for (Layout::Node* node : scannedUnit->records)
+            {
+                LayoutDatabase::AddRecord(database, node, scannedUnit->files, unitIndex);
+            }
+            scannedUnit->records.clear();
+        }
+
+        //a record reaching the units with different layouts is an odr violation, usually a macro or a packing pragma in effect before an include
+        const std::vector<LayoutDatabase::TRecordIndices> mismatches = LayoutDatabase::FindLayoutMismatches(database);
+        for (const LayoutDatabase::TRecordIndices& mismatch : mismatches)
+        {
+            LOG_WARNING("Layout mismatch: '%s' has different layouts across translation units", database.records[mismatch.front()].node->type.c_str());
+            for (const unsigned int recordIndex : mismatch)
+            {
+                const LayoutDatabase::Record& record = database.records[recordIndex];
+                const Layout::Location& location = record.node->typeLocation;
+                LOG_ALWAYS("    size %lld align %lld at %s:%u in %zu units (%s)", record.node->size, record.node->align, location.fileIndex >= 0 ? database.files[location.fileIndex].c_str() : "<unknown>", location.line,
+                    record.units.size(), database.units[record.units.front()].filename.c_str());
+            }
+        }
+
+        bool ret = true;
+        for (const int retCode : retCodes)
+        {
+            ret = ret && retCode == 0;
+        }
+
+        if (!ret)
+        {
+            LOG_ERROR("Some translation units failed to parse, their records are left out and they are parsed again on the next update");
+        }
+
+        //the same units give the same bytes whatever the jobs, shards or update history
+        LayoutDatabase::Canonicalize(database);
+
+        //write next to the database and rename it over so an interrupted update keeps the previous one
+        const std::string temporaryFilename = std::string(databaseFilename) + ".tmp";
+        if (!LayoutDatabase::ToFile(database, temporaryFilename.c_str()) || llvm::sys::fs::rename(temporaryFilename, databaseFilename))
+        {
+            LOG_ERROR("Unable to write the project database '%s'", databaseFilename);
+            llvm::sys::fs::remove(temporaryFilename);
+            ret = false;
+        }
+
+        LOG_INFO("Project: %zu translation units, %zu records, %zu layout mismatches", database.units.size(), database.records.size(), mismatches.size());
+
+        for (ClangParser::ParseState& state : states)
+        {
+            ClangParser::Helpers::ClearResult(state);
+        }
+        LayoutDatabase::Clear(database);
+        return ret;
+    }
+
+    bool IsCacheable()
+    {
+        //only the runs that write nothing but the result can be served from the cache
+        const ClangParser::Options& options = ClangParser::g_options;
+        return !options.cache.directory.empty() && !ClangParser::Helpers::HasReports() && options.soaFilename.empty() && options.reorder.diffFilename.empty() && !options.reorder.inPlace && 
+            options.instantiations.empty() && options.typeNames.empty() && CommandLine::g_targets.empty() && CommandLine::g_configs.empty();
+    }
+
     bool Parse(int argc, const char* argv[])
     { 
         llvm::InitializeNativeTarget();
         llvm::InitializeNativeTargetAsmParser();
 
-        llvm::Expected<clang::tooling::CommonOptionsParser> optionsParser = clang::tooling::CommonOptionsParser::create(argc, argv, CommandLine::g_commandLineCategory);
+        //the project update takes the whole compilation database when no sources are given
+        llvm::Expected<clang::tooling::CommonOptionsParser> optionsParser = clang::tooling::CommonOptionsParser::create(argc, argv, CommandLine::g_commandLineCategory, llvm::cl::ZeroOrMore);
         if (!optionsParser)
         {
             llvm::errs() << "Failed to create options parser: " << llvm::toString(optionsParser.takeError()) << "\n";
             return false;
         }
 
+        if (!CommandLine::g_projectFilename.empty())
+        {
+            return ParseProject(optionsParser->getCompilations(), optionsParser->getSourcePathList(), CommandLine::g_projectFilename.c_str());
+        }
+
+        if (optionsParser->getSourcePathList().empty())
+        {
+            LOG_ERROR("No source files given");
+            return false;
+        }
+
         clang::tooling::ClangTool tool(optionsParser->getCompilations(), optionsParser->getSourcePathList());
 
         SetFilter(ClangParser::LocationFilter{ CommandLine::g_locationRow, CommandLine::g_locationCol });
+        SetOptions(GatherOptions());
+
+        //the instantiations are appended to the main file buffer, the in place rewrite would write them back into the source
+        if (!ClangParser::g_options.instantiations.empty() && ClangParser::g_options.reorder.inPlace)
+        {
+            LOG_ERROR("-instantiate can not be used together with -reorderInPlace, use -reorder to get the changes as a diff");
+            return false;
+        }
+
+        const char* outputFileName = CommandLine::g_outputFilename.size() == 0 ? "output.slbin" : CommandLine::g_outputFilename.c_str();
+
+        const bool isCacheable = IsCacheable();
+        const std::string cacheKey = isCacheable ? ResultCache::ComputeKey(optionsParser->getCompilations(), optionsParser->getSourcePathList(), std::to_string(CommandLine::g_locationRow) + ':' + std::to_string(CommandLine::g_locationCol)) : std::string();
+        if (isCacheable && ResultCache::Fetch(ClangParser::g_options.cache, cacheKey, outputFileName))
+        {
+            LOG_INFO("Result fetched from the cache");
+            return true;
+        }
 
-        const int retCode = tool.run(clang::tooling::newFrontendActionFactory<ClangParser::Action>().get());
+        TVirtualFiles virtualFiles;
+        if (!ClangParser::g_options.instantiations.empty() && !InjectInstantiations(tool, virtualFiles, optionsParser->getSourcePathList(), ClangParser::g_options.instantiations))
+        {
+            return false;
+        }
+
+        //the headers shared by the translation units only get their layouts computed once per context
+        ClangParser::g_state.useLayoutCache = optionsParser->getSourcePathList().size() > 1;
+
+        ClangParser::ActionFactory factory(ClangParser::g_state);
+        const int retCode = tool.run(&factory);
 
         bool ret = retCode == 0;
         if (ret)
         {
-            const char* outputFileName = CommandLine::g_outputFilename.size() == 0 ? "output.slbin" : CommandLine::g_outputFilename.c_str();
-            ret = IO::ToFile(ClangParser::g_result, outputFileName);
+            ret = IO::ToFile(ClangParser::g_state.result, outputFileName);
+            ret = WriteQueries(ClangParser::g_state, outputFileName) && ret;
+        }
+
+        //the layout is still written, the run fails so scripts notice the missing generated files
+        ret = ret && !ClangParser::g_state.hasActionFailed;
+
+        if (ret && isCacheable)
+        {
+            ResultCache::Store(ClangParser::g_options.cache, cacheKey, ClangParser::g_state.dependencies, outputFileName);
+        }
+
+        if (ret && !CommandLine::g_targets.empty())
+        {
+            TVariants variants;
+            for (const std::string& triple : CommandLine::g_targets)
+            {
+                variants.push_back(Variant{ triple, GetTargetAdjuster(triple) });
+            }
+            ret = ParseVariants(optionsParser->getCompilations(), optionsParser->getSourcePathList(), variants, "Target layouts", ClangParser::Helpers::HasReports());
+        }
+
+        if (ret && !CommandLine::g_configs.empty())
+        {
+            TVariants variants;
+            for (const std::string& config : CommandLine::g_configs)
+            {
+                variants.push_back(GetConfigVariant(config));
+            }
+            ret = ParseVariants(optionsParser->getCompilations(), optionsParser->getSourcePathList(), variants, "Configuration layouts", ClangParser::Helpers::HasReports() || !CommandLine::g_targets.empty());
         }
 
-        ClangParser::Helpers::ClearResult();
+        ClangParser::Helpers::ClearResult(ClangParser::g_state);
         return ret;
     }
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "RegisterPassing.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/Basic/TargetInfo.h>
+#include <clang/CodeGen/CGFunctionInfo.h>
+#include <clang/CodeGen/CodeGenABITypes.h>
+#include <clang/CodeGen/ModuleBuilder.h>
+#include <clang/Frontend/CompilerInstance.h>
+
+// LLVM includes
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Type.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <memory>
+#include <string>
+
+#include "IO.h"
+#include "Report.h"
+
+namespace RegisterPassing
+{
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsInRegisters(const clang::CodeGen::ABIArgInfo& info)
+        {
+            switch (info.getKind())
+            {
+            case clang::CodeGen::ABIArgInfo::Direct:
+            case clang::CodeGen::ABIArgInfo::Extend:
+            case clang::CodeGen::ABIArgInfo::Ignore:
+            case clang::CodeGen::ABIArgInfo::Expand:
+            case clang::CodeGen::ABIArgInfo::CoerceAndExpand:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        std::string GetDescription(const clang::CodeGen::ABIArgInfo& info)
+        {
+            std::string description;
+            llvm::raw_string_ostream stream(description);
+
+            switch (info.getKind())
+            {
+            case clang::CodeGen::ABIArgInfo::Direct:          stream << "registers"; break;
+            case clang::CodeGen::ABIArgInfo::Extend:          stream << "registers (extended)"; break;
+            case clang::CodeGen::ABIArgInfo::Ignore:          stream << "nothing (empty)"; break;
+            case clang::CodeGen::ABIArgInfo::Expand:          stream << "registers (one per field)"; break;
+            case clang::CodeGen::ABIArgInfo::CoerceAndExpand: stream << "registers (coerced and expanded)"; break;
+            case clang::CodeGen::ABIArgInfo::Indirect:        stream << (info.getIndirectByVal() ? "memory (copy on the stack)" : "memory (pointer to a copy)"); break;
+            case clang::CodeGen::ABIArgInfo::InAlloca:        stream << "memory (inalloca)"; break;
+            default:                                          stream << "memory"; break;
+            }
+
+            if (info.canHaveCoerceToType() && info.getCoerceToType())
+            {
+                stream << " as ";
+                info.getCoerceToType()->print(stream);
+            }
+
+            return stream.str();
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        // first base or field that makes the record non trivial for the purpose of calls
+        std::string FindNonTrivialMember(const clang::CXXRecordDecl* declaration)
+        {
+            for (const clang::CXXBaseSpecifier& base : declaration->bases())
+            {
+                const clang::CXXRecordDecl* baseDeclaration = base.getType()->getAsCXXRecordDecl();
+                if (baseDeclaration && !baseDeclaration->canPassInRegisters())
+                {
+                    return "base " + baseDeclaration->getQualifiedNameAsString();
+                }
+            }
+
+            for (const clang::FieldDecl* field : declaration->fields())
+            {
+                const clang::CXXRecordDecl* fieldDeclaration = field->getType()->getBaseElementTypeUnsafe()->getAsCXXRecordDecl();
+                if (fieldDeclaration && !fieldDeclaration->canPassInRegisters())
+                {
+                    return "field " + field->getNameAsString() + " (" + fieldDeclaration->getQualifiedNameAsString() + ")";
+                }
+            }
+
+            if (declaration->hasNonTrivialDestructorForCall())
+            {
+                return "its destructor";
+            }
+
+            return "its copy or move constructors";
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void WriteSuggestions(const Report::Context& context, const bool inRegisters)
+    {
+        const clang::TargetInfo& target = context.ast.getTargetInfo();
+        const llvm::Triple& triple = target.getTriple();
+        const Layout::TAmount size = context.ast.getTypeSizeInChars(context.ast.getRecordType(context.declaration)).getQuantity();
+
+        if (!context.declaration->canPassInRegisters())
+        {
+            context.out << "  Non trivial for the purpose of calls because of " << Helpers::FindNonTrivialMember(context.declaration) << ", it is always passed by address\n";
+            return;
+        }
+
+        if (inRegisters)
+        {
+            return;
+        }
+
+        if (triple.getArch() == llvm::Triple::x86_64 && triple.isOSWindows())
+        {
+            //only records of exactly 1, 2, 4 or 8 bytes go in a register
+            if (size < 8)
+            {
+                Layout::TAmount registerSize = 1;
+                while (registerSize < size) registerSize *= 2;
+                context.out << "  Windows x64 passes records of 1, 2, 4 or 8 bytes in registers: pad " << context.declaration->getName() << " by " << (registerSize - size) << " bytes to " << registerSize << " bytes\n";
+            }
+            else
+            {
+                context.out << "  Windows x64 passes records of 1, 2, 4 or 8 bytes in registers: shrink " << context.declaration->getName() << " by " << (size - 8) << " bytes to 8 bytes\n";
+            }
+            return;
+        }
+
+        if (triple.getArch() == llvm::Triple::x86_64 || triple.getArch() == llvm::Triple::aarch64)
+        {
+            //System V x86-64 and AAPCS64 pass records up to two eightbytes in registers
+            if (size > 16)
+            {
+                context.out << "  Records larger than 16 bytes are passed in memory: shrink " << context.declaration->getName() << " by " << (size - 16) << " bytes";
+
+                std::string candidates;
+                for (const clang::FieldDecl* field : context.declaration->fields())
+                {
+                    if (!field->isBitField() && context.ast.getTypeSizeInChars(field->getType()).getQuantity() >= size - 16)
+                    {
+                        candidates += (candidates.empty() ? "" : ", ") + field->getNameAsString();
+                    }
+                }
+
+                if (!candidates.empty())
+                {
+                    context.out << ", moving out any of " << candidates << " would be enough";
+                }
+                context.out << "\n";
+            }
+            else
+            {
+                context.out << "  Classified as memory despite its size: look for unaligned (packed) fields or x87 long double fields\n";
+            }
+            return;
+        }
+
+        context.out << "  No suggestion available for " << triple.str() << "\n";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context, clang::CompilerInstance& compiler)
+    {
+        Report::WriteTitle(context, "Register passing");
+
+        const clang::TargetInfo& target = context.ast.getTargetInfo();
+        context.out << "  Target: " << target.getTriple().str() << "\n";
+
+        if (context.declaration->isDependentType())
+        {
+            context.out << "  Dependent types have no calling convention.\n";
+            return;
+        }
+
+        //a code generator is only created to reach the target ABI classification, no code is emitted
+        llvm::LLVMContext llvmContext;
+        std::unique_ptr<clang::CodeGenerator> generator(clang::CreateLLVMCodeGen(compiler.getDiagnostics(), "StructLayout", &compiler.getVirtualFileSystem(), compiler.getHeaderSearchOpts(), compiler.getPreprocessorOpts(), compiler.getCodeGenOpts(), llvmContext));
+        if (!generator)
+        {
+            LOG_ERROR("Unable to create the code generator for %s", target.getTriple().str().c_str());
+            return;
+        }
+
+        generator->Initialize(compiler.getASTContext());
+
+        const clang::CanQualType recordType = context.ast.getCanonicalType(context.ast.getRecordType(context.declaration));
+        const clang::CodeGen::CGFunctionInfo& functionInfo = clang::CodeGen::arrangeFreeFunctionCall(generator->CGM(), recordType, { recordType }, clang::FunctionType::ExtInfo(), clang::CodeGen::RequiredArgs::All);
+
+        const clang::CodeGen::ABIArgInfo& argumentInfo = functionInfo.arguments().begin()->info;
+        const clang::CodeGen::ABIArgInfo& returnInfo   = functionInfo.getReturnInfo();
+
+        context.out << "  Passed as argument in " << Helpers::GetDescription(argumentInfo) << "\n";
+        context.out << "  Returned in " << Helpers::GetDescription(returnInfo) << "\n";
+
+        WriteSuggestions(context, Helpers::IsInRegisters(argumentInfo) && Helpers::IsInRegisters(returnInfo));
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace clang
+{
+    class CompilerInstance;
+}
+
+namespace Report
+{
+    struct Context;
+}
+
+namespace RegisterPassing
+{
+    void Analyze(const Report::Context& context, clang::CompilerInstance& compiler);
+}
@@ -0,0 +1,215 @@
+#include "Relocation.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/Type.h>
+#include <clang/Sema/Sema.h>
+
+// LLVM includes
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <string>
+
+#include "Report.h"
+
+namespace Relocation
+{
+    enum { MAX_DEPTH = 8 };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        const clang::CXXRecordDecl* GetRecord(const clang::QualType& type)
+        {
+            const clang::CXXRecordDecl* declaration = type->getBaseElementTypeUnsafe()->getAsCXXRecordDecl();
+            return declaration && declaration->hasDefinition() ? declaration->getDefinition() : nullptr;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        // A property check returns what breaks it, or an empty string when it holds
+        template<typename TCheck> std::string FindSubobject(const clang::CXXRecordDecl* declaration, const TCheck& check)
+        {
+            for (const clang::CXXBaseSpecifier& base : declaration->bases())
+            {
+                const clang::CXXRecordDecl* baseDeclaration = GetRecord(base.getType());
+                if (baseDeclaration && !check(baseDeclaration).empty())
+                {
+                    return "base " + baseDeclaration->getQualifiedNameAsString();
+                }
+            }
+
+            for (const clang::FieldDecl* field : declaration->fields())
+            {
+                const clang::CXXRecordDecl* fieldDeclaration = GetRecord(field->getType());
+                if (fieldDeclaration && !check(fieldDeclaration).empty())
+                {
+                    return "field " + field->getNameAsString() + " (" + fieldDeclaration->getQualifiedNameAsString() + ")";
+                }
+            }
+
+            return std::string();
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        const clang::CXXConstructorDecl* FindConstructor(const clang::CXXRecordDecl* declaration, const bool isMove)
+        {
+            for (const clang::CXXConstructorDecl* constructor : declaration->ctors())
+            {
+                if (isMove ? constructor->isMoveConstructor() : constructor->isCopyConstructor())
+                {
+                    return constructor;
+                }
+            }
+            return nullptr;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::string CheckTriviallyCopyable(const clang::CXXRecordDecl* declaration)
+    {
+        if (declaration->isTriviallyCopyable())
+        {
+            return std::string();
+        }
+
+        const std::string subobject = Helpers::FindSubobject(declaration, CheckTriviallyCopyable);
+        if (!subobject.empty())           return subobject;
+        if (declaration->isPolymorphic()) return "virtual functions";
+        if (declaration->getNumVBases())  return "virtual bases";
+
+        if (declaration->hasNonTrivialCopyConstructor()) return "copy constructor";
+        if (declaration->hasNonTrivialMoveConstructor()) return "move constructor";
+        if (declaration->hasNonTrivialCopyAssignment())  return "copy assignment";
+        if (declaration->hasNonTrivialMoveAssignment())  return "move assignment";
+        if (!declaration->hasTrivialDestructor())        return "destructor";
+        return "deleted copy and move operations";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::string CheckTriviallyDestructible(const clang::CXXRecordDecl* declaration)
+    {
+        if (declaration->hasTrivialDestructor())
+        {
+            return std::string();
+        }
+
+        const std::string subobject = Helpers::FindSubobject(declaration, CheckTriviallyDestructible);
+        if (!subobject.empty())
+        {
+            return subobject;
+        }
+
+        const clang::CXXDestructorDecl* destructor = declaration->getDestructor();
+        return destructor && destructor->isVirtual() ? "virtual destructor" : "user provided destructor";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::string CheckNothrowMoveConstructible(clang::Sema& sema, const clang::CXXRecordDecl* declaration)
+    {
+        if (declaration->hasTrivialMoveConstructor())
+        {
+            return std::string();
+        }
+
+        //the constructor overload resolution would pick for an rvalue, the copy constructor when there is no move constructor
+        const clang::CXXConstructorDecl* constructor = Helpers::FindConstructor(declaration, true);
+        const bool isMove = constructor != nullptr || declaration->needsImplicitMoveConstructor();
+        if (!isMove)
+        {
+            constructor = Helpers::FindConstructor(declaration, false);
+        }
+
+        if (constructor && constructor->isDeleted())
+        {
+            return isMove ? "deleted move constructor" : "deleted copy constructor";
+        }
+
+        //implicit and defaulted constructors are noexcept when all the subobject ones are
+        if (!constructor || !constructor->isUserProvided())
+        {
+            return Helpers::FindSubobject(declaration, [&sema](const clang::CXXRecordDecl* subobject) { return CheckNothrowMoveConstructible(sema, subobject); });
+        }
+
+        //a conditional noexcept of a template stays uninstantiated until something asks, isNothrow is false until then
+        const clang::FunctionProtoType* prototype = constructor->getType()->getAs<clang::FunctionProtoType>();
+        if (prototype && clang::isUnresolvedExceptionSpec(prototype->getExceptionSpecType()))
+        {
+            prototype = sema.ResolveExceptionSpec(constructor->getLocation(), prototype);
+        }
+
+        if (prototype && prototype->isNothrow())
+        {
+            return std::string();
+        }
+
+        return isMove ? "move constructor is not noexcept" : "no move constructor, the copy constructor is not noexcept";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void WriteRecord(const Report::Context& context, clang::Sema& sema, const clang::CXXRecordDecl* declaration, const std::string& label, const unsigned int depth)
+    {
+        const std::string copyable     = CheckTriviallyCopyable(declaration);
+        const std::string destructible = CheckTriviallyDestructible(declaration);
+        const std::string nothrowMove  = CheckNothrowMoveConstructible(sema, declaration);
+
+        const std::string indent(2 * depth, ' ');
+        context.out << "    " << llvm::left_justify(indent + label, 56) << llvm::left_justify(copyable.empty() ? "yes" : "NO", 10) << llvm::left_justify(destructible.empty() ? "yes" : "NO", 10) << (nothrowMove.empty() ? "yes" : "NO") << "\n";
+
+        if (!copyable.empty())     context.out << "    " << indent << "  not trivially copyable: " << copyable << "\n";
+        if (!destructible.empty()) context.out << "    " << indent << "  not trivially destructible: " << destructible << "\n";
+        if (!nothrowMove.empty())  context.out << "    " << indent << "  not nothrow move constructible: " << nothrowMove << "\n";
+
+        //subobjects in the same order as the layout tree, std internals are not expanded
+        if (depth >= MAX_DEPTH || declaration->isInStdNamespace())
+        {
+            return;
+        }
+
+        for (const clang::CXXBaseSpecifier& base : declaration->bases())
+        {
+            if (const clang::CXXRecordDecl* baseDeclaration = Helpers::GetRecord(base.getType()))
+            {
+                WriteRecord(context, sema, baseDeclaration, std::string(base.isVirtual() ? "virtual base " : "base ") + baseDeclaration->getQualifiedNameAsString(), depth + 1);
+            }
+        }
+
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            if (const clang::CXXRecordDecl* fieldDeclaration = Helpers::GetRecord(field->getType()))
+            {
+                WriteRecord(context, sema, fieldDeclaration, field->getNameAsString() + " (" + Report::GetTypeName(context.ast, field->getType()) + ")", depth + 1);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context, clang::Sema& sema)
+    {
+        Report::WriteTitle(context, "Relocation");
+
+        context.out << "    " << llvm::left_justify("", 56) << llvm::left_justify("trivial", 10) << llvm::left_justify("trivial", 10) << "nothrow\n";
+        context.out << "    " << llvm::left_justify("record", 56) << llvm::left_justify("copy", 10) << llvm::left_justify("dtor", 10) << "move\n";
+
+        WriteRecord(context, sema, context.declaration, context.declaration->getQualifiedNameAsString(), 0u);
+
+        //what std::vector does with the elements when it grows
+        if (CheckTriviallyCopyable(context.declaration).empty())
+        {
+            context.out << "  std::vector growth relocates elements with memcpy\n";
+        }
+        else if (CheckNothrowMoveConstructible(sema, context.declaration).empty())
+        {
+            context.out << "  std::vector growth moves elements one by one\n";
+        }
+        else
+        {
+            context.out << "  std::vector growth copies elements one by one (move_if_noexcept falls back to the copy constructor)\n";
+        }
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace clang
+{
+    class Sema;
+}
+
+namespace Report
+{
+    struct Context;
+}
+
+namespace Relocation
+{
+    // Sema resolves the exception specifications not instantiated yet
+    void Analyze(const Report::Context& context, clang::Sema& sema);
+}
@@ -0,0 +1,250 @@
+#include "Report.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Attr.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/RecordLayout.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Basic/TargetInfo.h>
+
+// LLVM includes
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+
+namespace Report
+{
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount Simulate(const Shape& shape, const TMembers& members)
+        {
+            Layout::TAmount offset = shape.fieldsStart;
+            Layout::TAmount align  = shape.minAlign;
+            for (const Member& member : members)
+            {
+                offset = AlignTo(offset, member.align) + member.size;
+                align  = std::max(align, member.align);
+            }
+
+            const Layout::TAmount size = AlignTo(AlignTo(offset, align) + shape.tailSize, align);
+            return size > 0 ? size : 1;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount ApplyPacking(const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const Layout::TAmount align)
+        {
+            if (declaration->hasAttr<clang::PackedAttr>())
+            {
+                return 1;
+            }
+
+            if (const clang::MaxFieldAlignmentAttr* packAttribute = declaration->getAttr<clang::MaxFieldAlignmentAttr>())
+            {
+                return std::min(align, std::max<Layout::TAmount>(1, context.toCharUnitsFromBits(packAttribute->getAlignment()).getQuantity()));
+            }
+
+            return align;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        uint64_t GetDataEndInBits(const clang::ASTContext& context, const clang::CXXRecordDecl* declaration)
+        {
+            const clang::ASTRecordLayout& layout = context.getASTRecordLayout(declaration);
+
+            uint64_t dataEnd = declaration->isDynamicClass() ? context.getTargetInfo().getPointerWidth(clang::LangAS::Default) : 0u;
+            for (const clang::CXXBaseSpecifier& base : declaration->bases())
+            {
+                const clang::CXXRecordDecl* baseDeclaration = base.getType()->getAsCXXRecordDecl();
+                if (!base.isVirtual() && !baseDeclaration->isEmpty())
+                {
+                    dataEnd = std::max(dataEnd, static_cast<uint64_t>(context.toBits(layout.getBaseClassOffset(baseDeclaration))) + GetDataEndInBits(context, baseDeclaration));
+                }
+            }
+
+            for (const clang::FieldDecl* field : declaration->fields())
+            {
+                const uint64_t width = field->isBitField() ? field->getBitWidthValue(context) : field->isZeroSize(context) ? 0u : context.getTypeSize(field->getType());
+                dataEnd = std::max(dataEnd, layout.getFieldOffset(field->getFieldIndex()) + width);
+            }
+
+            return dataEnd;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void ComputeShape(Shape& output, const clang::ASTContext& context, const clang::CXXRecordDecl* declaration)
+    {
+        const clang::ASTRecordLayout& layout = context.getASTRecordLayout(declaration);
+        const clang::TargetInfo& target = context.getTargetInfo();
+
+        const Layout::TAmount pointerSize  = context.toCharUnitsFromBits(target.getPointerWidth(clang::LangAS::Default)).getQuantity();
+        const Layout::TAmount pointerAlign = context.toCharUnitsFromBits(target.getPointerAlign(clang::LangAS::Default)).getQuantity();
+
+        output.members.clear();
+        output.fieldsStart = 0;
+        output.minAlign    = std::max<Layout::TAmount>(1, context.toCharUnitsFromBits(declaration->getMaxAlignment()).getQuantity());
+        output.tailSize    = layout.getSize().getQuantity() - layout.getNonVirtualSize().getQuantity();
+
+        //vptrs and bases stay where they are
+        if (declaration->isDynamicClass())
+        {
+            output.fieldsStart = pointerSize;
+            output.minAlign    = std::max(output.minAlign, pointerAlign);
+        }
+
+        if (layout.hasOwnVBPtr())
+        {
+            output.fieldsStart = std::max(output.fieldsStart, layout.getVBPtrOffset().getQuantity() + pointerSize);
+            output.minAlign    = std::max(output.minAlign, pointerAlign);
+        }
+
+        for (const clang::CXXBaseSpecifier& base : declaration->bases())
+        {
+            const clang::CXXRecordDecl* baseDeclaration = base.getType()->getAsCXXRecordDecl();
+            const clang::ASTRecordLayout& baseLayout = context.getASTRecordLayout(baseDeclaration);
+            output.minAlign = std::max(output.minAlign, baseLayout.getAlignment().getQuantity());
+
+            if (!base.isVirtual() && !baseDeclaration->isEmpty())
+            {
+                output.fieldsStart = std::max(output.fieldsStart, layout.getBaseClassOffset(baseDeclaration).getQuantity() + baseLayout.getNonVirtualSize().getQuantity());
+            }
+        }
+
+        for (const clang::CXXBaseSpecifier& base : declaration->vbases())
+        {
+            output.minAlign = std::max(output.minAlign, context.getASTRecordLayout(base.getType()->getAsCXXRecordDecl()).getAlignment().getQuantity());
+        }
+
+        //fields, collapsing the bitfields that share a storage unit
+        uint64_t unitBegin = 0u;
+        uint64_t unitEnd   = 0u;
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            const uint64_t bitOffset = layout.getFieldOffset(field->getFieldIndex());
+
+            Member member{ field, 0, 1, 0 };
+            if (field->isBitField())
+            {
+                const uint64_t width = field->getBitWidthValue(context);
+                if (width == 0)
+                {
+                    continue;
+                }
+
+                if (!output.members.empty() && output.members.back().field->isBitField() && bitOffset >= unitBegin && bitOffset + width <= unitEnd)
+                {
+                    output.members.back().bits += width;
+                    continue;
+                }
+
+                const uint64_t unitBits = context.getTypeSize(field->getType());
+                unitBegin = bitOffset - (bitOffset % unitBits);
+                unitEnd   = unitBegin + unitBits;
+
+                member.size  = context.toCharUnitsFromBits(unitBits).getQuantity();
+                member.align = context.getTypeAlignInChars(field->getType()).getQuantity();
+                member.bits  = width;
+            }
+            else
+            {
+                member.size  = field->isZeroSize(context) ? 0 : context.getTypeSizeInChars(field->getType()).getQuantity();
+                member.align = context.getDeclAlign(field).getQuantity();
+                member.bits  = member.size * 8;
+            }
+
+            member.align = Helpers::ApplyPacking(context, declaration, member.align);
+            output.members.push_back(member);
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    Layout::TAmount ComputeSize(const Shape& shape)
+    {
+        return Helpers::Simulate(shape, shape.members);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    Layout::TAmount ComputeSortedSize(const Shape& shape)
+    {
+        TMembers members = shape.members;
+        std::stable_sort(members.begin(), members.end(), [](const Member& a, const Member& b) { return a.align > b.align; });
+        return Helpers::Simulate(shape, members);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    Layout::TAmount GetDataEnd(const clang::ASTContext& context, const clang::CXXRecordDecl* declaration)
+    {
+        return AlignTo(Helpers::GetDataEndInBits(context, declaration), context.getCharWidth()) / context.getCharWidth();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    Layout::TAmount AlignTo(const Layout::TAmount value, const Layout::TAmount align)
+    {
+        return align > 1 ? ((value + align - 1) / align) * align : value;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    unsigned int GetRequiredBits(const clang::EnumDecl* declaration, bool& isSigned)
+    {
+        const unsigned int positiveBits = declaration->getNumPositiveBits();
+        const unsigned int negativeBits = declaration->getNumNegativeBits();
+
+        isSigned = negativeBits > 0;
+        return isSigned ? std::max(positiveBits + 1, negativeBits) : std::max(positiveBits, 1u);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool IsStdType(const clang::QualType& type, const char* name)
+    {
+        const clang::CXXRecordDecl* declaration = type.getCanonicalType()->getAsCXXRecordDecl();
+        return declaration && declaration->getIdentifier() && declaration->isInStdNamespace() && declaration->getName() == name;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool IsAtomic(const clang::QualType& type)
+    {
+        return type->isAtomicType() || IsStdType(type, "atomic") || IsStdType(type, "atomic_ref");
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::string GetTypeName(const clang::ASTContext& context, const clang::QualType& type)
+    {
+        return type.getAsString(context.getPrintingPolicy());
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::string GetLocationString(const clang::ASTContext& context, const clang::SourceLocation& location)
+    {
+        const clang::PresumedLoc presumedLocation = context.getSourceManager().getPresumedLoc(location);
+        if (!location.isValid() || !presumedLocation.isValid())
+        {
+            return "<unknown>";
+        }
+
+        return std::string(presumedLocation.getFilename()) + ':' + std::to_string(presumedLocation.getLine()) + ':' + std::to_string(presumedLocation.getColumn());
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::string GetLocationString(const Layout::Result& result, const Layout::Location& location)
+    {
+        if (location.fileIndex < 0 || location.fileIndex >= static_cast<int>(result.files.size()))
+        {
+            return "<unknown>";
+        }
+
+        return result.files[location.fileIndex] + ':' + std::to_string(location.line) + ':' + std::to_string(location.column);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void WriteTitle(const Context& context, const char* title)
+    {
+        const clang::ASTRecordLayout& layout = context.ast.getASTRecordLayout(context.declaration);
+        context.out << "\n== " << title << ": " << context.declaration->getQualifiedNameAsString() << " (size " << layout.getSize().getQuantity() << ", align " << layout.getAlignment().getQuantity() << ") ==\n";
+    }
+}
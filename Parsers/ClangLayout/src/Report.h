@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "LayoutDefinitions.h"
+
+namespace clang
+{
+    class ASTContext;
+    class CXXRecordDecl;
+    class EnumDecl;
+    class FieldDecl;
+    class QualType;
+    class SourceLocation;
+}
+
+namespace llvm
+{
+    class raw_ostream;
+}
+
+namespace Report
+{
+    // Everything an analysis needs to know about the queried record
+    struct Context
+    {
+        const clang::ASTContext&    ast;
+        const clang::CXXRecordDecl* declaration;
+        const Layout::Result&       result;
+        llvm::raw_ostream&          out;
+    };
+
+    // A storage unit of the record: a field or a run of bitfields sharing their storage
+    struct Member
+    {
+        const clang::FieldDecl* field;
+        Layout::TAmount         size;
+        Layout::TAmount         align;
+        Layout::TAmount         bits;   //bits in use, smaller than size * 8 for bitfield runs
+    };
+
+    using TMembers = std::vector<Member>;
+
+    struct Shape
+    {
+        TMembers        members;      //in layout order
+        Layout::TAmount fieldsStart;  //first byte after the vptrs and the non virtual bases
+        Layout::TAmount minAlign;     //alignment required by everything that is not a field
+        Layout::TAmount tailSize;     //virtual bases placed after the non virtual part
+    };
+
+    void ComputeShape(Shape& output, const clang::ASTContext& context, const clang::CXXRecordDecl* declaration);
+
+    // Sizes are simulated with the same rules for every variation so they can be compared against each other
+    Layout::TAmount ComputeSize(const Shape& shape);
+    Layout::TAmount ComputeSortedSize(const Shape& shape);
+
+    // End of the last byte holding data, before the tail padding
+    Layout::TAmount GetDataEnd(const clang::ASTContext& context, const clang::CXXRecordDecl* declaration);
+
+    Layout::TAmount AlignTo(const Layout::TAmount value, const Layout::TAmount align);
+
+    unsigned int GetRequiredBits(const clang::EnumDecl* declaration, bool& isSigned);
+
+    bool IsStdType(const clang::QualType& type, const char* name);
+    bool IsAtomic(const clang::QualType& type);
+
+    std::string GetTypeName(const clang::ASTContext& context, const clang::QualType& type);
+    std::string GetLocationString(const clang::ASTContext& context, const clang::SourceLocation& location);
+    std::string GetLocationString(const Layout::Result& result, const Layout::Location& location);
+
+    void WriteTitle(const Context& context, const char* title);
+}
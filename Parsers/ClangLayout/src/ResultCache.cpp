@@ -0,0 +1,309 @@
+#include "ResultCache.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/Basic/FileManager.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Tooling.h>
+
+// LLVM includes
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Chrono.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <optional>
+#include <unordered_set>
+
+#include "IO.h"
+
+namespace ResultCache
+{
+    //bump when the result format or the layout computation changes
+    enum { CACHE_VERSION = 1 };
+
+    constexpr const char* ENTRY_HEADER    = "StructLayoutCache";
+    constexpr const char* ENTRY_EXTENSION = ".slcache";
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        std::string ToHex(const uint64_t value)
+        {
+            std::string output;
+            llvm::raw_string_ostream stream(output);
+            stream << llvm::format_hex_no_prefix(value, 16);
+            return stream.str();
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        std::string GetEntryPath(const Params& params, const std::string& key)
+        {
+            llvm::SmallString<256> path(params.directory);
+            llvm::sys::path::append(path, key + ENTRY_EXTENSION);
+            return path.str().str();
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        std::unique_ptr<llvm::MemoryBuffer> ReadFile(const llvm::Twine& filename)
+        {
+            //read instead of mapping the file so other processes can still replace or evict it
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(filename, false, false, true);
+            return buffer ? std::move(*buffer) : nullptr;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void Touch(const std::string& path)
+        {
+            //the modification time doubles as the last use for the eviction
+            int fd = -1;
+            if (!llvm::sys::fs::openFileForReadWrite(path, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_None))
+            {
+                const llvm::sys::TimePoint<> now = std::chrono::system_clock::now();
+                llvm::sys::fs::setLastAccessAndModificationTime(fd, now, now);
+                llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void Evict(const Params& params)
+        {
+            struct Entry
+            {
+                std::string             path;
+                uint64_t                size;
+                llvm::sys::TimePoint<>  lastUse;
+            };
+
+            std::vector<Entry> entries;
+            uint64_t totalSize = 0u;
+
+            std::error_code errorCode;
+            for (llvm::sys::fs::directory_iterator it(params.directory, errorCode), end; it != end && !errorCode; it.increment(errorCode))
+            {
+                llvm::sys::fs::file_status status;
+                if (llvm::sys::path::extension(it->path()) == ENTRY_EXTENSION && !llvm::sys::fs::status(it->path(), status))
+                {
+                    entries.push_back(Entry{ it->path(), status.getSize(), status.getLastModificationTime() });
+                    totalSize += status.getSize();
+                }
+            }
+
+            const uint64_t sizeLimit = static_cast<uint64_t>(params.sizeLimitMB) * 1024u * 1024u;
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+
+            //entries in use by another process fail to be removed and are simply skipped
+            for (size_t i = 0; i < entries.size() && totalSize > sizeLimit; ++i)
+            {
+                if (!llvm::sys::fs::remove(entries[i].path))
+                {
+                    totalSize -= entries[i].size;
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    uint64_t HashCompileCommand(const clang::tooling::CompilationDatabase& compilations, const std::string& source)
+    {
+        const std::string path = clang::tooling::getAbsolutePath(source);
+        std::string text = path + '\0';
+
+        for (const clang::tooling::CompileCommand& command : compilations.getCompileCommands(path))
+        {
+            text += command.Directory + '\0';
+            for (const std::string& argument : command.CommandLine)
+            {
+                text += argument + '\0';
+            }
+        }
+        return llvm::xxHash64(text);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::string ComputeKey(const clang::tooling::CompilationDatabase& compilations, const std::vector<std::string>& sources, const std::string& query)
+    {
+        std::string text = std::string(ENTRY_HEADER) + ' ' + std::to_string(CACHE_VERSION) + '\0' + query + '\0';
+        for (const std::string& source : sources)
+        {
+            text += Helpers::ToHex(HashCompileCommand(compilations, source)) + '\0';
+        }
+        return Helpers::ToHex(llvm::xxHash64(text));
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void CollectDependencies(TDependencies& output, const clang::SourceManager& sourceManager)
+    {
+        std::unordered_set<std::string> visited;
+        for (const Dependency& dependency : output)
+        {
+            visited.insert(dependency.filename);
+        }
+
+        for (unsigned int i = 0u, count = sourceManager.local_sloc_entry_size(); i < count; ++i)
+        {
+            const clang::SrcMgr::SLocEntry& entry = sourceManager.getLocalSLocEntry(i);
+            if (!entry.isFile())
+            {
+                continue;
+            }
+
+            //skip the predefines and command line buffers
+            const clang::SrcMgr::FileInfo& file = entry.getFile();
+            if (file.getName().empty() || file.getName().starts_with("<"))
+            {
+                continue;
+            }
+
+            //hash what the parse saw rather than what is on disk now
+            const std::optional<llvm::MemoryBufferRef> buffer = file.getContentCache().getBufferIfLoaded();
+            if (!buffer)
+            {
+                continue;
+            }
+
+            llvm::SmallString<256> path(file.getName());
+            sourceManager.getFileManager().makeAbsolutePath(path);
+
+            if (visited.insert(path.str().str()).second)
+            {
+                output.push_back(Dependency{ path.str().str(), llvm::xxHash64(buffer->getBuffer()) });
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool IsUpToDate(const TDependencies& dependencies, TFileHashes& hashes)
+    {
+        for (const Dependency& dependency : dependencies)
+        {
+            const std::pair<TFileHashes::iterator, bool> found = hashes.emplace(dependency.filename, 0u);
+            if (found.second)
+            {
+                std::unique_ptr<llvm::MemoryBuffer> buffer = Helpers::ReadFile(dependency.filename);
+                found.first->second = buffer ? llvm::xxHash64(buffer->getBuffer()) : 0u;
+            }
+
+            if (found.first->second != dependency.hash)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Fetch(const Params& params, const std::string& key, const char* outputFilename)
+    {
+        const std::string entryPath = Helpers::GetEntryPath(params, key);
+        std::unique_ptr<llvm::MemoryBuffer> entry = Helpers::ReadFile(entryPath);
+        if (!entry)
+        {
+            return false;
+        }
+
+        //header line, dependency count and one 'hash filename' line per dependency, the result follows
+        llvm::StringRef remaining = entry->getBuffer();
+        const auto ReadLine = [&remaining]() { const std::pair<llvm::StringRef, llvm::StringRef> split = remaining.split('\n'); remaining = split.second; return split.first; };
+
+        if (ReadLine() != std::string(ENTRY_HEADER) + ' ' + std::to_string(CACHE_VERSION))
+        {
+            return false;
+        }
+
+        unsigned int count = 0u;
+        if (ReadLine().getAsInteger(10, count))
+        {
+            return false;
+        }
+
+        TDependencies dependencies;
+        for (unsigned int i = 0u; i < count; ++i)
+        {
+            const std::pair<llvm::StringRef, llvm::StringRef> line = ReadLine().split(' ');
+
+            dependencies.push_back(Dependency{ line.second.str(), 0u });
+            if (line.first.getAsInteger(16, dependencies.back().hash))
+            {
+                return false;
+            }
+        }
+
+        TFileHashes hashes;
+        if (!IsUpToDate(dependencies, hashes))
+        {
+            return false;
+        }
+
+        std::error_code errorCode;
+        llvm::raw_fd_ostream output(outputFilename, errorCode);
+        if (errorCode)
+        {
+            LOG_ERROR("Unable to open '%s' for writing: %s", outputFilename, errorCode.message().c_str());
+            return false;
+        }
+
+        output << remaining;
+        output.close();
+
+        //clear the error so the stream does not abort on destruction
+        const bool ret = !output.has_error();
+        output.clear_error();
+
+        Helpers::Touch(entryPath);
+        return ret;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Store(const Params& params, const std::string& key, const TDependencies& dependencies, const char* resultFilename)
+    {
+        std::unique_ptr<llvm::MemoryBuffer> result = Helpers::ReadFile(resultFilename);
+        if (!result || llvm::sys::fs::create_directories(params.directory))
+        {
+            LOG_WARNING("Unable to store the result in the cache directory '%s'", params.directory.c_str());
+            return;
+        }
+
+        //write a unique temporary file and rename it over the entry, readers see either the old or the new entry
+        int fd = -1;
+        llvm::SmallString<256> temporaryPath;
+        llvm::SmallString<256> model(params.directory);
+        llvm::sys::path::append(model, key + "-%%%%%%%%.tmp");
+        if (llvm::sys::fs::createUniqueFile(model, fd, temporaryPath))
+        {
+            LOG_WARNING("Unable to create a temporary file in the cache directory '%s'", params.directory.c_str());
+            return;
+        }
+
+        llvm::raw_fd_ostream output(fd, true);
+        output << ENTRY_HEADER << ' ' << CACHE_VERSION << '\n' << dependencies.size() << '\n';
+        for (const Dependency& dependency : dependencies)
+        {
+            output << Helpers::ToHex(dependency.hash) << ' ' << dependency.filename << '\n';
+        }
+        output << result->getBuffer();
+        output.close();
+
+        const bool isWritten = !output.has_error();
+        output.clear_error();
+
+        //another process might be reading the entry, it will be stored on the next parse
+        if (!isWritten || llvm::sys::fs::rename(temporaryPath, Helpers::GetEntryPath(params, key)))
+        {
+            llvm::sys::fs::remove(temporaryPath);
+            return;
+        }
+
+        Helpers::Evict(params);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LayoutDatabase.h"
+
+namespace clang
+{
+    class SourceManager;
+
+    namespace tooling
+    {
+        class CompilationDatabase;
+    }
+}
+
+namespace ResultCache
+{
+    struct Params
+    {
+        std::string  directory;           //caching is disabled when empty
+        unsigned int sizeLimitMB = 256u;
+    };
+
+    using Dependency    = LayoutDatabase::Dependency;
+    using TDependencies = LayoutDatabase::TDependencies;
+    using TFileHashes   = std::unordered_map<std::string, uint64_t>; //contents hash by filename, 0 when unreadable
+
+    // Hashes the absolute path of the source and its compile commands
+    uint64_t HashCompileCommand(const clang::tooling::CompilationDatabase& compilations, const std::string& source);
+
+    // Hashes everything but the include closure: the sources, their compile commands and the query
+    std::string ComputeKey(const clang::tooling::CompilationDatabase& compilations, const std::vector<std::string>& sources, const std::string& query);
+
+    // Appends every file entered by the parse, main files included
+    void CollectDependencies(TDependencies& output, const clang::SourceManager& sourceManager);
+
+    // Compares the dependencies against the files on disk, each file is only read once per hashes map
+    bool IsUpToDate(const TDependencies& dependencies, TFileHashes& hashes);
+
+    // Copies the stored result to the output when none of its dependencies changed
+    bool Fetch(const Params& params, const std::string& key, const char* outputFilename);
+
+    // Stores the result file along with its dependencies, safe with other processes doing the same
+    void Store(const Params& params, const std::string& key, const TDependencies& dependencies, const char* resultFilename);
+}
@@ -0,0 +1,479 @@
+#include "SoAGenerator.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/QualTypeNames.h>
+#include <clang/AST/RecordLayout.h>
+#include <clang/Basic/SourceManager.h>
+
+// LLVM includes
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <string>
+#include <vector>
+
+#include "LayoutDefinitions.h"
+#include "IO.h"
+
+namespace SoAGenerator
+{
+    struct FieldEntry
+    {
+        std::string     name;
+        std::string     type;
+        Layout::TAmount offset;
+        Layout::TAmount size;
+        Layout::TAmount align;
+    };
+
+    using TFields = std::vector<FieldEntry>;
+
+    //the field names are used as is inside the generated proxy reference, they cannot shadow its own names
+    constexpr const char* RESERVED_NAMES[] = { "Field", "IsConst" };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsPowerOfTwo(const unsigned int value)
+        {
+            return value && (value & (value - 1)) == 0;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        std::string GetIncludePath(const clang::ASTContext& context, const clang::CXXRecordDecl* declaration)
+        {
+            const clang::SourceManager& sourceManager = context.getSourceManager();
+            const clang::SourceLocation location = sourceManager.getExpansionLoc(declaration->getLocation());
+            if (!location.isValid() || sourceManager.getFileID(location) == sourceManager.getMainFileID())
+            {
+                return "";
+            }
+
+            std::string ret = sourceManager.getFilename(location).str();
+            for (char& c : ret)
+            {
+                if (c == '\\') c = '/';
+            }
+            return ret;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool CollectFields(TFields& output, const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, bool& allPublic)
+        {
+            if (declaration->isDynamicClass())
+            {
+                LOG_ERROR("SoA generation failed: '%s' is polymorphic.", declaration->getQualifiedNameAsString().c_str());
+                return false;
+            }
+
+            for (const clang::CXXBaseSpecifier& base : declaration->bases())
+            {
+                const clang::CXXRecordDecl* baseDeclaration = base.getType()->getAsCXXRecordDecl();
+                if (base.isVirtual() || !baseDeclaration || !baseDeclaration->isEmpty())
+                {
+                    LOG_ERROR("SoA generation failed: '%s' has non empty bases.", declaration->getQualifiedNameAsString().c_str());
+                    return false;
+                }
+            }
+
+            const clang::ASTRecordLayout& layout = context.getASTRecordLayout(declaration);
+            const clang::PrintingPolicy& policy = context.getPrintingPolicy();
+
+            allPublic = true;
+            for (const clang::FieldDecl* field : declaration->fields())
+            {
+                const std::string fieldName = field->getNameAsString();
+
+                if (fieldName.empty() || field->isAnonymousStructOrUnion())
+                {
+                    LOG_ERROR("SoA generation failed: unnamed members are not supported.");
+                    return false;
+                }
+
+                for (const char* reservedName : RESERVED_NAMES)
+                {
+                    if (fieldName == reservedName)
+                    {
+                        LOG_ERROR("SoA generation failed: member '%s' clashes with a name of the generated container.", fieldName.c_str());
+                        return false;
+                    }
+                }
+
+                if (field->isBitField())
+                {
+                    LOG_ERROR("SoA generation failed: bitfield '%s' cannot be split into its own array.", fieldName.c_str());
+                    return false;
+                }
+
+                if (field->getType()->isReferenceType())
+                {
+                    LOG_ERROR("SoA generation failed: reference member '%s' cannot be stored in an array.", fieldName.c_str());
+                    return false;
+                }
+
+                const clang::TypeInfoChars fieldInfo = context.getTypeInfoInChars(field->getType());
+
+                FieldEntry entry;
+                entry.name   = fieldName;
+                entry.type   = clang::TypeName::getFullyQualifiedName(field->getType().getUnqualifiedType(), context, policy, true);
+                entry.offset = context.toCharUnitsFromBits(layout.getFieldOffset(field->getFieldIndex())).getQuantity();
+                entry.size   = fieldInfo.Width.getQuantity();
+                entry.align  = fieldInfo.Align.getQuantity();
+                output.push_back(entry);
+
+                allPublic &= field->getAccess() == clang::AS_public;
+            }
+
+            if (output.empty())
+            {
+                LOG_ERROR("SoA generation failed: '%s' has no fields.", declaration->getQualifiedNameAsString().c_str());
+                return false;
+            }
+
+            return true;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void WriteHeader(llvm::raw_ostream& out, const std::string& typeName, const std::string& includePath, const Layout::Node& node, const TFields& fields)
+    {
+        out << "// Generated by ClangLayout from '" << typeName << "' - do not edit by hand, regenerate instead.\n";
+        out << "//\n";
+        out << "// Source layout: size " << node.size << " - align " << node.align << "\n";
+        out << "//   offset     size    align  field\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "//   " << llvm::format_decimal(field.offset, 6) << "   " << llvm::format_decimal(field.size, 6) << "   " << llvm::format_decimal(field.align, 6) << "  " << field.name << "\n";
+        }
+        out << "\n";
+        out << "#pragma once\n";
+        out << "\n";
+        out << "#include <cstddef>\n";
+        out << "#include <cstring>\n";
+        out << "#include <iterator>\n";
+        out << "#include <new>\n";
+        out << "#include <type_traits>\n";
+        out << "#include <utility>\n";
+        out << "\n";
+
+        if (includePath.empty())
+        {
+            out << "// '" << typeName << "' is defined in the parsed translation unit, include its definition before this header.\n";
+        }
+        else
+        {
+            out << "#include \"" << includePath << "\"\n";
+        }
+        out << "\n";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void WriteClass(llvm::raw_ostream& out, const std::string& className, const std::string& typeName, const Layout::Node& node, const TFields& fields, const unsigned int vectorWidth, const bool allPublic)
+    {
+        out << "class " << className << "\n";
+        out << "{\n";
+        out << "public:\n";
+        out << "    using value_type = " << typeName << ";\n";
+        out << "\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "    using " << field.name << "_t = " << field.type << ";\n";
+        }
+        out << "\n";
+        out << "    static constexpr std::size_t VectorWidth = " << vectorWidth << ";\n";
+        out << "\n";
+
+        //proxy reference
+        out << "    template<bool IsConst> struct ReferenceT\n";
+        out << "    {\n";
+        out << "        template<typename T> using Field = std::conditional_t<IsConst, const T, T>&;\n";
+        out << "\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "        Field<" << field.name << "_t> " << field.name << ";\n";
+        }
+        out << "    };\n";
+        out << "\n";
+        out << "    using Reference      = ReferenceT<false>;\n";
+        out << "    using ConstReference = ReferenceT<true>;\n";
+        out << "\n";
+
+        //iterators
+        out << "    template<bool IsConst> class IteratorT\n";
+        out << "    {\n";
+        out << "    public:\n";
+        out << "        using iterator_category = std::random_access_iterator_tag;\n";
+        out << "        using value_type        = ReferenceT<IsConst>;\n";
+        out << "        using difference_type   = std::ptrdiff_t;\n";
+        out << "        using reference         = ReferenceT<IsConst>;\n";
+        out << "        using pointer           = void;\n";
+        out << "        using Container         = std::conditional_t<IsConst, const " << className << ", " << className << ">;\n";
+        out << "\n";
+        out << "        IteratorT() : m_container(nullptr), m_index(0) {}\n";
+        out << "        IteratorT(Container* container, std::size_t index) : m_container(container), m_index(index) {}\n";
+        out << "\n";
+        out << "        reference operator*() const { return (*m_container)[m_index]; }\n";
+        out << "        reference operator[](difference_type n) const { return (*m_container)[m_index + n]; }\n";
+        out << "\n";
+        out << "        IteratorT& operator++() { ++m_index; return *this; }\n";
+        out << "        IteratorT& operator--() { --m_index; return *this; }\n";
+        out << "        IteratorT  operator++(int) { IteratorT ret = *this; ++m_index; return ret; }\n";
+        out << "        IteratorT  operator--(int) { IteratorT ret = *this; --m_index; return ret; }\n";
+        out << "        IteratorT& operator+=(difference_type n) { m_index += n; return *this; }\n";
+        out << "        IteratorT& operator-=(difference_type n) { m_index -= n; return *this; }\n";
+        out << "        IteratorT  operator+(difference_type n) const { return IteratorT(m_container, m_index + n); }\n";
+        out << "        IteratorT  operator-(difference_type n) const { return IteratorT(m_container, m_index - n); }\n";
+        out << "        difference_type operator-(const IteratorT& other) const { return difference_type(m_index) - difference_type(other.m_index); }\n";
+        out << "\n";
+        out << "        bool operator==(const IteratorT& other) const { return m_index == other.m_index; }\n";
+        out << "        bool operator!=(const IteratorT& other) const { return m_index != other.m_index; }\n";
+        out << "        bool operator< (const IteratorT& other) const { return m_index <  other.m_index; }\n";
+        out << "        bool operator> (const IteratorT& other) const { return m_index >  other.m_index; }\n";
+        out << "        bool operator<=(const IteratorT& other) const { return m_index <= other.m_index; }\n";
+        out << "        bool operator>=(const IteratorT& other) const { return m_index >= other.m_index; }\n";
+        out << "\n";
+        out << "    private:\n";
+        out << "        Container*  m_container;\n";
+        out << "        std::size_t m_index;\n";
+        out << "    };\n";
+        out << "\n";
+        out << "    using Iterator      = IteratorT<false>;\n";
+        out << "    using ConstIterator = IteratorT<true>;\n";
+        out << "\n";
+
+        //construction
+        out << "    " << className << "()\n";
+        out << "        : m_size(0)\n";
+        out << "        , m_capacity(0)\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "        , m_field_" << field.name << "(nullptr)\n";
+        }
+        out << "    {}\n";
+        out << "\n";
+        out << "    explicit " << className << "(std::size_t capacity) : " << className << "() { reserve(capacity); }\n";
+        out << "\n";
+        out << "    " << className << "(const " << className << "&) = delete;\n";
+        out << "    " << className << "& operator=(const " << className << "&) = delete;\n";
+        out << "\n";
+        out << "    ~" << className << "() { clear(); Release(); }\n";
+        out << "\n";
+
+        //capacity
+        out << "    std::size_t size() const     { return m_size; }\n";
+        out << "    std::size_t capacity() const { return m_capacity; }\n";
+        out << "    bool        empty() const    { return m_size == 0; }\n";
+        out << "\n";
+        //the locals and parameters are prefixed so no field name can shadow the members they use
+        out << "    void reserve(std::size_t newCapacity)\n";
+        out << "    {\n";
+        out << "        if (newCapacity <= m_capacity) return;\n";
+        out << "\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "        " << field.name << "_t* new_" << field.name << " = Allocate<" << field.name << "_t>(newCapacity);\n";
+        }
+        out << "\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "        Relocate(new_" << field.name << ", m_field_" << field.name << ", m_size);\n";
+        }
+        out << "\n";
+        out << "        Release();\n";
+        out << "\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "        m_field_" << field.name << " = new_" << field.name << ";\n";
+        }
+        out << "        m_capacity = newCapacity;\n";
+        out << "    }\n";
+        out << "\n";
+        out << "    void clear()\n";
+        out << "    {\n";
+        out << "        for (std::size_t i = 0; i < m_size; ++i)\n";
+        out << "        {\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "            Destroy(&m_field_" << field.name << "[i]);\n";
+        }
+        out << "        }\n";
+        out << "        m_size = 0;\n";
+        out << "    }\n";
+        out << "\n";
+
+        //modifiers
+        if (allPublic)
+        {
+            out << "    void push_back(const value_type& value)\n";
+            out << "    {\n";
+            out << "        push_back(";
+            for (size_t i = 0; i < fields.size(); ++i)
+            {
+                out << (i ? ", " : "") << "value." << fields[i].name;
+            }
+            out << ");\n";
+            out << "    }\n";
+            out << "\n";
+        }
+
+        out << "    void push_back(";
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            out << (i ? ", " : "") << "const " << fields[i].name << "_t& new_" << fields[i].name;
+        }
+        out << ")\n";
+        out << "    {\n";
+        out << "        if (m_size == m_capacity) reserve(m_capacity ? m_capacity * 2 : VectorWidth);\n";
+        out << "\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "        Construct(&m_field_" << field.name << "[m_size], new_" << field.name << ");\n";
+        }
+        out << "        ++m_size;\n";
+        out << "    }\n";
+        out << "\n";
+        out << "    void pop_back()\n";
+        out << "    {\n";
+        out << "        --m_size;\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "        Destroy(&m_field_" << field.name << "[m_size]);\n";
+        }
+        out << "    }\n";
+        out << "\n";
+
+        //access
+        for (int isConst = 0; isConst < 2; ++isConst)
+        {
+            out << "    " << (isConst ? "ConstReference" : "Reference     ") << " operator[](std::size_t index)" << (isConst ? " const" : "      ") << " { return { ";
+            for (size_t i = 0; i < fields.size(); ++i)
+            {
+                out << (i ? ", " : "") << "m_field_" << fields[i].name << "[index]";
+            }
+            out << " }; }\n";
+        }
+        out << "\n";
+        out << "    Iterator      begin()        { return Iterator(this, 0); }\n";
+        out << "    Iterator      end()          { return Iterator(this, m_size); }\n";
+        out << "    ConstIterator begin() const  { return ConstIterator(this, 0); }\n";
+        out << "    ConstIterator end() const    { return ConstIterator(this, m_size); }\n";
+        out << "    ConstIterator cbegin() const { return ConstIterator(this, 0); }\n";
+        out << "    ConstIterator cend() const   { return ConstIterator(this, m_size); }\n";
+        out << "\n";
+
+        //raw arrays for SIMD loops
+        out << "    // Each array is aligned to and padded up to VectorWidth bytes, the padding lanes are zeroed.\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "    " << field.name << "_t*       " << field.name << "_data()       { return m_field_" << field.name << "; }\n";
+            out << "    const " << field.name << "_t* " << field.name << "_data() const { return m_field_" << field.name << "; }\n";
+        }
+        out << "\n";
+
+        //internals
+        out << "private:\n";
+        out << "    template<typename T> static constexpr std::size_t ArrayAlignment() { return alignof(T) > VectorWidth ? alignof(T) : VectorWidth; }\n";
+        out << "    template<typename T> static std::size_t PaddedBytes(std::size_t count) { return ((count * sizeof(T) + VectorWidth - 1) / VectorWidth) * VectorWidth; }\n";
+        out << "\n";
+        out << "    template<typename T> static T* Allocate(std::size_t count)\n";
+        out << "    {\n";
+        out << "        const std::size_t bytes = PaddedBytes<T>(count);\n";
+        out << "        void* memory = ::operator new(bytes, std::align_val_t(ArrayAlignment<T>()));\n";
+        out << "        std::memset(memory, 0, bytes);\n";
+        out << "        return static_cast<T*>(memory);\n";
+        out << "    }\n";
+        out << "\n";
+        out << "    template<typename T> static void Free(T* memory)\n";
+        out << "    {\n";
+        out << "        if (memory) ::operator delete(static_cast<void*>(memory), std::align_val_t(ArrayAlignment<T>()));\n";
+        out << "    }\n";
+        out << "\n";
+        out << "    template<typename T, typename S> static void Construct(T* target, S&& source) { ::new (static_cast<void*>(target)) T(std::forward<S>(source)); }\n";
+        out << "    template<typename T, std::size_t N, typename S> static void Construct(T (*target)[N], S&& source) { for (std::size_t i = 0; i < N; ++i) Construct(&(*target)[i], std::forward<S>(source)[i]); }\n";
+        out << "\n";
+        out << "    template<typename T> static void Destroy(T* target) { target->~T(); }\n";
+        out << "    template<typename T, std::size_t N> static void Destroy(T (*target)[N]) { for (std::size_t i = 0; i < N; ++i) Destroy(&(*target)[i]); }\n";
+        out << "\n";
+        out << "    template<typename T> static void Relocate(T* target, T* source, std::size_t count)\n";
+        out << "    {\n";
+        out << "        if constexpr (std::is_trivially_copyable_v<T>)\n";
+        out << "        {\n";
+        out << "            if (count) std::memcpy(static_cast<void*>(target), static_cast<const void*>(source), count * sizeof(T));\n";
+        out << "        }\n";
+        out << "        else\n";
+        out << "        {\n";
+        out << "            for (std::size_t i = 0; i < count; ++i)\n";
+        out << "            {\n";
+        out << "                Construct(&target[i], std::move(source[i]));\n";
+        out << "                Destroy(&source[i]);\n";
+        out << "            }\n";
+        out << "        }\n";
+        out << "    }\n";
+        out << "\n";
+        out << "    void Release()\n";
+        out << "    {\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "        Free(m_field_" << field.name << ");\n";
+        }
+        out << "    }\n";
+        out << "\n";
+        out << "private:\n";
+        out << "    std::size_t m_size;\n";
+        out << "    std::size_t m_capacity;\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "    " << field.name << "_t* m_field_" << field.name << ";\n";
+        }
+        out << "};\n";
+        out << "\n";
+
+        //keep the generated container in sync with the source record
+        out << "static_assert(sizeof(" << typeName << ") == " << node.size << ", \"'" << typeName << "' changed, regenerate " << className << "\");\n";
+        for (const FieldEntry& field : fields)
+        {
+            out << "static_assert(sizeof(" << className << "::" << field.name << "_t) == " << field.size << ", \"'" << typeName << "::" << field.name << "' changed, regenerate " << className << "\");\n";
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Generate(const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const Layout::Node& node, const unsigned int vectorWidth, const char* filename)
+    {
+        if (!Helpers::IsPowerOfTwo(vectorWidth))
+        {
+            LOG_ERROR("SoA generation failed: the vector width (%u) must be a power of two.", vectorWidth);
+            return false;
+        }
+
+        TFields fields;
+        bool allPublic = true;
+        if (!Helpers::CollectFields(fields, context, declaration, allPublic))
+        {
+            return false;
+        }
+
+        std::error_code errorCode;
+        llvm::raw_fd_ostream out(filename, errorCode, llvm::sys::fs::OF_Text);
+        if (errorCode)
+        {
+            LOG_ERROR("Unable to open '%s' for writing: %s", filename, errorCode.message().c_str());
+            return false;
+        }
+
+        const std::string typeName  = clang::TypeName::getFullyQualifiedName(context.getRecordType(declaration), context, context.getPrintingPolicy());
+        const std::string className = declaration->getNameAsString() + "SoA";
+
+        WriteHeader(out, typeName, Helpers::GetIncludePath(context, declaration), node, fields);
+        WriteClass(out, className, typeName, node, fields, vectorWidth, allPublic);
+
+        LOG_INFO("Generated %s with %u arrays at '%s'.", className.c_str(), static_cast<unsigned int>(fields.size()), filename);
+        return true;
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace clang
+{
+    class ASTContext;
+    class CXXRecordDecl;
+}
+
+namespace Layout
+{
+    struct Node;
+}
+
+namespace SoAGenerator
+{
+    bool Generate(const clang::ASTContext& context, const clang::CXXRecordDecl* declaration, const Layout::Node& node, const unsigned int vectorWidth, const char* filename);
+}
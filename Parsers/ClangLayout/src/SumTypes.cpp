@@ -0,0 +1,235 @@
+#include "SumTypes.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/Basic/TargetInfo.h>
+
+// LLVM includes
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Report.h"
+
+namespace SumTypes
+{
+    struct Alternative
+    {
+        std::string     name;
+        Layout::TAmount size;
+        Layout::TAmount align;
+    };
+
+    using TAlternatives = std::vector<Alternative>;
+
+    enum { MAX_DEPTH = 8 };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        Alternative MakeAlternative(const clang::ASTContext& context, const std::string& name, const clang::QualType& type)
+        {
+            const clang::TypeInfoChars info = context.getTypeInfoInChars(type);
+            return Alternative{ name, info.Width.getQuantity(), info.Align.getQuantity() };
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        const clang::TemplateArgumentList* GetTemplateArguments(const clang::QualType& type)
+        {
+            const clang::ClassTemplateSpecializationDecl* specialization = llvm::dyn_cast_or_null<clang::ClassTemplateSpecializationDecl>(type.getCanonicalType()->getAsCXXRecordDecl());
+            return specialization ? &specialization->getTemplateArgs() : nullptr;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Layout::TAmount GetPointerSize(const clang::ASTContext& context)
+        {
+            return context.toCharUnitsFromBits(context.getTargetInfo().getPointerWidth(clang::LangAS::Default)).getQuantity();
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void WriteAlternatives(const Report::Context& context, const TAlternatives& alternatives, const Layout::TAmount totalSize)
+    {
+        context.out << "      " << llvm::left_justify("alternative", 40) << "    size   waste\n";
+        for (const Alternative& alternative : alternatives)
+        {
+            context.out << "      " << llvm::left_justify(alternative.name, 40) << llvm::format_decimal(alternative.size, 8) << llvm::format_decimal(totalSize - alternative.size, 8) << "\n";
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void SuggestBoxing(const Report::Context& context, const TAlternatives& alternatives, const Layout::TAmount discriminatorSize)
+    {
+        if (alternatives.size() < 2)
+        {
+            return;
+        }
+
+        //box the largest alternative when it is at least twice the size of all the others
+        TAlternatives sorted = alternatives;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Alternative& a, const Alternative& b) { return a.size > b.size; });
+
+        const Layout::TAmount pointerSize = Helpers::GetPointerSize(context.ast);
+        const Alternative& largest = sorted[0];
+        if (largest.size < 2 * std::max(sorted[1].size, pointerSize))
+        {
+            return;
+        }
+
+        Layout::TAmount boxedSize  = pointerSize;
+        Layout::TAmount boxedAlign = pointerSize;
+        for (size_t i = 1; i < sorted.size(); ++i)
+        {
+            boxedSize  = std::max(boxedSize, sorted[i].size);
+            boxedAlign = std::max(boxedAlign, sorted[i].align);
+        }
+        boxedSize = Report::AlignTo(Report::AlignTo(boxedSize, discriminatorSize ? discriminatorSize : 1) + discriminatorSize, boxedAlign);
+
+        context.out << "    suggestion: box '" << largest.name << "' (" << largest.size << " bytes) behind a pointer, estimated size " << boxedSize << " bytes\n";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void ReportVariant(const Report::Context& context, const std::string& path, const clang::QualType& type, const Layout::TAmount size)
+    {
+        const clang::TemplateArgumentList* arguments = Helpers::GetTemplateArguments(type);
+        if (!arguments || arguments->size() == 0 || arguments->get(0).getKind() != clang::TemplateArgument::Pack)
+        {
+            return;
+        }
+
+        TAlternatives alternatives;
+        Layout::TAmount largest = 0;
+        for (const clang::TemplateArgument& argument : arguments->get(0).pack_elements())
+        {
+            const clang::QualType alternativeType = argument.getAsType();
+            alternatives.push_back(Helpers::MakeAlternative(context.ast, Report::GetTypeName(context.ast, alternativeType), alternativeType));
+            largest = std::max(largest, alternatives.back().size);
+        }
+
+        if (alternatives.empty())
+        {
+            return;
+        }
+
+        //assume every alternative is equally likely without a profile
+        Layout::TAmount totalWaste = 0;
+        for (const Alternative& alternative : alternatives)
+        {
+            totalWaste += size - alternative.size;
+        }
+
+        const Layout::TAmount discriminatorSize = size - largest;
+
+        context.out << "  variant   " << path << " (" << Report::GetTypeName(context.ast, type) << ") size " << size << "\n";
+        WriteAlternatives(context, alternatives, size);
+        context.out << "    discriminator + padding: " << discriminatorSize << " bytes\n";
+        context.out << "    expected waste (uniform alternatives): " << totalWaste / static_cast<Layout::TAmount>(alternatives.size()) << " bytes\n";
+
+        SuggestBoxing(context, alternatives, alternatives.size() < 256 ? 1 : 2);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void ReportOptional(const Report::Context& context, const std::string& path, const clang::QualType& type, const Layout::TAmount size)
+    {
+        const clang::TemplateArgumentList* arguments = Helpers::GetTemplateArguments(type);
+        if (!arguments || arguments->size() == 0 || arguments->get(0).getKind() != clang::TemplateArgument::Type)
+        {
+            return;
+        }
+
+        const clang::QualType valueType = arguments->get(0).getAsType();
+        const Alternative value = Helpers::MakeAlternative(context.ast, Report::GetTypeName(context.ast, valueType), valueType);
+
+        context.out << "  optional  " << path << " (" << Report::GetTypeName(context.ast, type) << ") size " << size << "\n";
+        context.out << "    value '" << value.name << "' " << value.size << " bytes, engaged flag + padding: " << (size - value.size) << " bytes\n";
+
+        if (size - value.size >= value.align && value.align > 1)
+        {
+            context.out << "    suggestion: keep the engaged flag in a shared bitmask or use a sentinel value of '" << value.name << "'\n";
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void ReportUnion(const Report::Context& context, const std::string& path, const clang::QualType& type, const clang::RecordDecl* declaration, const Layout::TAmount size)
+    {
+        TAlternatives alternatives;
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            alternatives.push_back(Helpers::MakeAlternative(context.ast, field->getNameAsString() + " (" + Report::GetTypeName(context.ast, field->getType()) + ")", field->getType()));
+        }
+
+        if (alternatives.empty())
+        {
+            return;
+        }
+
+        Layout::TAmount totalWaste = 0;
+        for (const Alternative& alternative : alternatives)
+        {
+            totalWaste += size - alternative.size;
+        }
+
+        context.out << "  union     " << path << " (" << Report::GetTypeName(context.ast, type) << ") size " << size << "\n";
+        WriteAlternatives(context, alternatives, size);
+        context.out << "    expected waste (uniform alternatives): " << totalWaste / static_cast<Layout::TAmount>(alternatives.size()) << " bytes\n";
+
+        SuggestBoxing(context, alternatives, 0);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    unsigned int AnalyzeRecord(const Report::Context& context, const clang::RecordDecl* declaration, const std::string& prefix, const unsigned int depth)
+    {
+        unsigned int found = 0u;
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            const clang::QualType type = context.ast.getBaseElementType(field->getType());
+            const std::string path = prefix + (field->getName().empty() ? std::string("(anonymous)") : field->getNameAsString());
+            const Layout::TAmount size = context.ast.getTypeSizeInChars(type).getQuantity();
+
+            if (Report::IsStdType(type, "variant"))
+            {
+                ReportVariant(context, path, type, size);
+                ++found;
+            }
+            else if (Report::IsStdType(type, "optional"))
+            {
+                ReportOptional(context, path, type, size);
+                ++found;
+            }
+            else if (const clang::RecordDecl* record = type->getAsRecordDecl())
+            {
+                if (record->isUnion())
+                {
+                    ReportUnion(context, path, type, record, size);
+                    ++found;
+                }
+
+                if (depth < MAX_DEPTH && !record->isInStdNamespace())
+                {
+                    found += AnalyzeRecord(context, record, path + '.', depth + 1);
+                }
+            }
+        }
+        return found;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context)
+    {
+        Report::WriteTitle(context, "Variant, optional and union overhead");
+
+        if (AnalyzeRecord(context, context.declaration, "", 0u) == 0u)
+        {
+            context.out << "  No variant, optional or union fields found.\n";
+        }
+    }
+}
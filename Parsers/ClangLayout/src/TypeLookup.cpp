@@ -0,0 +1,122 @@
+#include "TypeLookup.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/Sema/Lookup.h>
+#include <clang/Sema/Sema.h>
+
+// LLVM includes
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+#pragma warning(pop)
+
+#include "IO.h"
+
+namespace TypeLookup
+{
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        clang::CXXRecordDecl* GetRecord(clang::NamedDecl* declaration)
+        {
+            if (clang::CXXRecordDecl* record = llvm::dyn_cast<clang::CXXRecordDecl>(declaration))
+            {
+                return record;
+            }
+
+            if (const clang::TypedefNameDecl* alias = llvm::dyn_cast<clang::TypedefNameDecl>(declaration))
+            {
+                return alias->getUnderlyingType()->getAsCXXRecordDecl();
+            }
+
+            return nullptr;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        clang::DeclContext* GetScope(clang::Sema& sema, clang::NamedDecl* declaration)
+        {
+            if (clang::NamespaceDecl* namespaceDeclaration = llvm::dyn_cast<clang::NamespaceDecl>(declaration))
+            {
+                return namespaceDeclaration;
+            }
+
+            if (clang::NamespaceAliasDecl* namespaceAlias = llvm::dyn_cast<clang::NamespaceAliasDecl>(declaration))
+            {
+                return namespaceAlias->getNamespace();
+            }
+
+            //a specialization named through an alias might not be instantiated yet, complete it before looking inside
+            clang::CXXRecordDecl* record = GetRecord(declaration);
+            if (!record || record->isDependentType() || !sema.isCompleteType(declaration->getLocation(), sema.getASTContext().getRecordType(record)))
+            {
+                return nullptr;
+            }
+            return record->getDefinition();
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        clang::NamedDecl* LookupIn(clang::Sema& sema, clang::DeclContext* scope, const llvm::StringRef name, const bool isScope)
+        {
+            clang::LookupResult result(sema, clang::DeclarationName(&sema.getASTContext().Idents.get(name)), clang::SourceLocation(), isScope ? clang::Sema::LookupNestedNameSpecifierName : clang::Sema::LookupOrdinaryName);
+            if (!sema.LookupQualifiedName(result, scope))
+            {
+                return nullptr;
+            }
+
+            //a function may share the name of the class ('struct stat'), prefer the types
+            for (clang::NamedDecl* found : result)
+            {
+                clang::NamedDecl* declaration = found->getUnderlyingDecl();
+                if (llvm::isa<clang::TypeDecl>(declaration) || llvm::isa<clang::NamespaceDecl>(declaration) || llvm::isa<clang::NamespaceAliasDecl>(declaration) || llvm::isa<clang::ClassTemplateDecl>(declaration))
+                {
+                    return declaration;
+                }
+            }
+            return nullptr;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    const clang::CXXRecordDecl* Find(clang::Sema& sema, const std::string& qualifiedName)
+    {
+        llvm::SmallVector<llvm::StringRef, 4> names;
+        llvm::StringRef(qualifiedName).trim().split(names, "::", -1, false);
+
+        clang::DeclContext* scope = sema.getASTContext().getTranslationUnitDecl();
+        clang::NamedDecl* declaration = nullptr;
+        size_t numResolved = 0;
+        for (; numResolved < names.size() && scope; ++numResolved)
+        {
+            declaration = Helpers::LookupIn(sema, scope, names[numResolved].trim(), numResolved + 1 < names.size());
+            scope = declaration && numResolved + 1 < names.size() ? Helpers::GetScope(sema, declaration) : nullptr;
+        }
+
+        //stopping at an outer scope that cannot be looked into must not return that scope
+        if (!declaration || numResolved < names.size())
+        {
+            LOG_ERROR("Unable to find the type '%s'", qualifiedName.c_str());
+            return nullptr;
+        }
+
+        if (llvm::isa<clang::ClassTemplateDecl>(declaration))
+        {
+            LOG_ERROR("'%s' names a class template, use -instantiate with its arguments instead", qualifiedName.c_str());
+            return nullptr;
+        }
+
+        //a typedef of a template specialization might not be instantiated yet
+        const clang::CXXRecordDecl* record = Helpers::GetRecord(declaration);
+        if (!record || record->isDependentType() || !sema.isCompleteType(declaration->getLocation(), sema.getASTContext().getRecordType(record)))
+        {
+            LOG_ERROR("'%s' does not name a complete record", qualifiedName.c_str());
+            return nullptr;
+        }
+
+        return record->getDefinition();
+    }
+}
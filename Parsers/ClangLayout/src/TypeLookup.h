@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+namespace clang
+{
+    class CXXRecordDecl;
+    class Sema;
+}
+
+namespace TypeLookup
+{
+    // Resolves a qualified name such as 'ns::Foo' or 'ns::Outer::Inner' to a complete record, null when it does not name one
+    const clang::CXXRecordDecl* Find(clang::Sema& sema, const std::string& qualifiedName);
+}
@@ -0,0 +1,262 @@
+#include "UniqueRepresentation.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+
+// LLVM includes
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Report.h"
+
+namespace UniqueRepresentation
+{
+    enum { MAX_DEPTH = 8 };
+
+    // Bits covered by a leaf of the layout tree
+    struct Span
+    {
+        Layout::TAmount begin;
+        Layout::TAmount end;
+        std::string     name;
+    };
+
+    using TSpans = std::vector<Span>;
+
+    struct Hole
+    {
+        Layout::TAmount begin;
+        Layout::TAmount end;
+        std::string     after;
+    };
+
+    using THoles = std::vector<Hole>;
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        const char* GetPointerName(const Layout::Category nature)
+        {
+            switch (nature)
+            {
+            case Layout::Category::VTablePtr:  return "vptr";
+            case Layout::Category::VFTablePtr: return "vfptr";
+            case Layout::Category::VBTablePtr: return "vbptr";
+            case Layout::Category::VtorDisp:   return "vtordisp";
+            default:                           return nullptr;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void CollectSpans(TSpans& output, const Layout::Node& node, const Layout::TAmount offset, const std::string& prefix)
+    {
+        for (const Layout::Node* child : node.children)
+        {
+            const Layout::TAmount childOffset = offset + child->offset;
+
+            switch (child->nature)
+            {
+            case Layout::Category::SimpleField:
+                output.push_back(Span{ childOffset * 8, (childOffset + child->size) * 8, prefix + child->name });
+                break;
+
+            case Layout::Category::Bitfield:
+            {
+                //the bit offset and width are stored in the only child
+                const Layout::Node* extraData = child->children.empty() ? nullptr : child->children[0];
+                const Layout::TAmount bitOffset = childOffset * 8 + (extraData ? extraData->offset : 0);
+                output.push_back(Span{ bitOffset, bitOffset + (extraData ? extraData->size : child->size * 8), prefix + child->name });
+                break;
+            }
+
+            case Layout::Category::ComplexField:
+                CollectSpans(output, *child, childOffset, prefix + child->name + '.');
+                break;
+
+            case Layout::Category::NVPrimaryBase:
+            case Layout::Category::NVBase:
+            case Layout::Category::VPrimaryBase:
+            case Layout::Category::VBase:
+                CollectSpans(output, *child, childOffset, prefix);
+                break;
+
+            default:
+                if (const char* pointerName = Helpers::GetPointerName(child->nature))
+                {
+                    output.push_back(Span{ childOffset * 8, (childOffset + child->size) * 8, prefix + pointerName });
+                }
+                break;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void CollectHoles(THoles& output, const Layout::Node& root)
+    {
+        TSpans spans;
+        CollectSpans(spans, root, 0, "");
+
+        const Layout::TAmount totalBits = root.size * 8;
+        std::vector<const Span*> owner(static_cast<size_t>(totalBits), nullptr);
+        for (const Span& span : spans)
+        {
+            for (Layout::TAmount bit = std::max<Layout::TAmount>(span.begin, 0); bit < span.end && bit < totalBits; ++bit)
+            {
+                owner[static_cast<size_t>(bit)] = &span;
+            }
+        }
+
+        const Span* last = nullptr;
+        for (Layout::TAmount bit = 0; bit < totalBits; )
+        {
+            if (owner[static_cast<size_t>(bit)])
+            {
+                last = owner[static_cast<size_t>(bit)];
+                ++bit;
+                continue;
+            }
+
+            Hole hole{ bit, bit, last ? last->name : std::string("(start)") };
+            while (hole.end < totalBits && !owner[static_cast<size_t>(hole.end)])
+            {
+                ++hole.end;
+            }
+            output.push_back(hole);
+            bit = hole.end;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // fields the layout tree treats as opaque: floating point values and arrays of types with their own padding
+    unsigned int ReportOpaqueFields(const Report::Context& context, const clang::RecordDecl* declaration, const std::string& prefix, const unsigned int depth)
+    {
+        unsigned int found = 0u;
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            const clang::QualType type = field->getType();
+            const std::string path = prefix + field->getNameAsString();
+
+            if (type->getAsRecordDecl())
+            {
+                if (depth < MAX_DEPTH)
+                {
+                    found += ReportOpaqueFields(context, type->getAsRecordDecl(), path + '.', depth + 1);
+                }
+                continue;
+            }
+
+            if (field->isBitField() || context.ast.hasUniqueObjectRepresentations(type))
+            {
+                continue;
+            }
+
+            const clang::QualType elementType = context.ast.getBaseElementType(type);
+            const char* reason = elementType->isRealFloatingType() || elementType->isComplexType() ? "floating point: +0/-0 compare equal with different bytes, NaNs compare unequal with equal bytes" : "element type has padding";
+
+            context.out << "    field " << path << " (" << Report::GetTypeName(context.ast, type) << "): " << reason << "\n";
+            ++found;
+        }
+        return found;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context)
+    {
+        Report::WriteTitle(context, "Unique object representation");
+
+        const clang::QualType recordType = context.ast.getRecordType(context.declaration);
+        if (context.ast.hasUniqueObjectRepresentations(recordType))
+        {
+            context.out << "  Yes: instances can be hashed and compared bytewise.\n";
+            return;
+        }
+
+        context.out << "  No, prevented by:\n";
+
+        if (!context.declaration->isTriviallyCopyable())
+        {
+            context.out << "    the record is not trivially copyable\n";
+        }
+
+        THoles holes;
+        if (context.result.node)
+        {
+            CollectHoles(holes, *context.result.node);
+        }
+
+        Layout::TAmount paddingBits = 0;
+        for (const Hole& hole : holes)
+        {
+            const Layout::TAmount bits = hole.end - hole.begin;
+            paddingBits += bits;
+
+            context.out << "    padding at offset " << hole.begin / 8;
+            if (hole.begin % 8 != 0 || bits % 8 != 0)
+            {
+                context.out << " bit " << hole.begin % 8 << ": " << bits << " bits";
+            }
+            else
+            {
+                context.out << ": " << bits / 8 << " bytes";
+            }
+            context.out << " after " << hole.after << "\n";
+        }
+
+        const unsigned int opaqueFields = ReportOpaqueFields(context, context.declaration, "", 0u);
+
+        //minimal change
+        context.out << "  To make it bytewise hashable:\n";
+        if (!context.declaration->isTriviallyCopyable())
+        {
+            context.out << "    make the copy, move and destructor members trivial (defaulted)\n";
+        }
+
+        if (!holes.empty())
+        {
+            Report::Shape shape;
+            Report::ComputeShape(shape, context.ast, context.declaration);
+
+            Layout::TAmount usedBytes = shape.fieldsStart + shape.tailSize;
+            for (const Report::Member& member : shape.members)
+            {
+                usedBytes += member.size;
+            }
+
+            //reordering only helps when all the padding sits between the record own fields
+            const bool isTopLevelPadding = paddingBits == (Report::ComputeSize(shape) - usedBytes) * 8;
+            if (isTopLevelPadding && Report::ComputeSortedSize(shape) == usedBytes)
+            {
+                context.out << "    reorder the fields by decreasing alignment, it removes all " << paddingBits / 8 << " padding bytes\n";
+            }
+            else
+            {
+                for (const Hole& hole : holes)
+                {
+                    const Layout::TAmount bits = hole.end - hole.begin;
+                    if (hole.begin % 8 == 0 && bits % 8 == 0)
+                    {
+                        context.out << "    add an explicit 'char pad[" << bits / 8 << "]' member after " << hole.after << " and zero it on construction\n";
+                    }
+                    else
+                    {
+                        context.out << "    add an unused " << bits << " bit bitfield after " << hole.after << " and zero it on construction\n";
+                    }
+                }
+            }
+        }
+
+        if (opaqueFields > 0u)
+        {
+            context.out << "    store floating point values through their integer bit pattern (std::bit_cast) or hash a normalized copy\n";
+        }
+    }
+}
@@ -0,0 +1,299 @@
+#include "ZeroCopy.h"
+
+#pragma warning(push, 0)
+
+// Clang includes
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/Basic/TargetInfo.h>
+
+// LLVM includes
+#include <llvm/ADT/StringSwitch.h>
+#include <llvm/Support/raw_ostream.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Report.h"
+
+namespace ZeroCopy
+{
+    enum { MAX_DEPTH = 8 };
+
+    struct Issue
+    {
+        std::string location;
+        std::string path;
+        std::string reason;
+    };
+
+    using TIssues = std::vector<Issue>;
+    using TNodes  = std::vector<const Layout::Node*>;
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        // the field nodes of the layout tree, in declaration order
+        TNodes GetFieldNodes(const Layout::Node* node)
+        {
+            TNodes output;
+            if (node)
+            {
+                for (const Layout::Node* child : node->children)
+                {
+                    if (child->nature == Layout::Category::SimpleField || child->nature == Layout::Category::Bitfield || child->nature == Layout::Category::ComplexField)
+                    {
+                        output.push_back(child);
+                    }
+                }
+            }
+            return output;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        const Layout::Node* FindBaseNode(const Layout::Node* node, const std::string& type)
+        {
+            if (node)
+            {
+                for (const Layout::Node* child : node->children)
+                {
+                    if ((child->nature == Layout::Category::NVBase || child->nature == Layout::Category::NVPrimaryBase) && child->type == type)
+                    {
+                        return child;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        const char* GetTypedefIssue(const clang::ASTContext& context, const clang::QualType& type)
+        {
+            for (clang::QualType current = type; !current.isNull() && current != current.getCanonicalType(); current = current.getSingleStepDesugaredType(context))
+            {
+                if (const clang::TypedefType* typedefType = llvm::dyn_cast<clang::TypedefType>(current.getTypePtr()))
+                {
+                    const char* issue = llvm::StringSwitch<const char*>(typedefType->getDecl()->getName())
+                        .Cases("size_t", "ssize_t", "ptrdiff_t", "intptr_t", "uintptr_t", "pointer sized typedef")
+                        .Cases("time_t", "off_t", "clock_t", "platform dependent typedef")
+                        .Default(nullptr);
+
+                    if (issue)
+                    {
+                        return issue;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        const char* GetTypeIssue(const clang::ASTContext& context, const clang::QualType& type)
+        {
+            const clang::QualType elementType = context.getBaseElementType(type);
+
+            if (elementType->isReferenceType())                                       return "reference";
+            if (elementType->isMemberPointerType())                                   return "member pointer";
+            if (elementType->isAnyPointerType() || elementType->isBlockPointerType()) return "pointer";
+
+            if (const char* issue = GetTypedefIssue(context, elementType))
+            {
+                return issue;
+            }
+
+            if (const clang::EnumType* enumType = elementType->getAs<clang::EnumType>())
+            {
+                const clang::EnumDecl* enumDeclaration = enumType->getDecl();
+                if (!enumDeclaration->isFixed())
+                {
+                    return "enum without a fixed underlying type";
+                }
+                return GetTypeIssue(context, enumDeclaration->getIntegerType());
+            }
+
+            if (const clang::BuiltinType* builtinType = elementType->getAs<clang::BuiltinType>())
+            {
+                switch (builtinType->getKind())
+                {
+                case clang::BuiltinType::Long:
+                case clang::BuiltinType::ULong:      return "long is 4 bytes on LLP64 and ILP32, 8 bytes on LP64";
+                case clang::BuiltinType::WChar_S:
+                case clang::BuiltinType::WChar_U:    return "wchar_t is 2 bytes on Windows, 4 bytes elsewhere";
+                case clang::BuiltinType::LongDouble: return "long double size and alignment differ between every ABI";
+                default:                             return nullptr;
+                }
+            }
+
+            return nullptr;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void CheckRecord(TIssues& output, const Report::Context& context, const clang::CXXRecordDecl* declaration, const Layout::Node* node, const std::string& prefix, const unsigned int depth)
+    {
+        const std::string recordLocation = Report::GetLocationString(context.ast, declaration->getLocation());
+
+        if (declaration->isDynamicClass())
+        {
+            output.push_back(Issue{ recordLocation, prefix + declaration->getNameAsString(), "vptr, points into the process image" });
+        }
+
+        for (const clang::CXXBaseSpecifier& base : declaration->bases())
+        {
+            const clang::CXXRecordDecl* baseDeclaration = base.getType()->getAsCXXRecordDecl();
+            if (base.isVirtual())
+            {
+                output.push_back(Issue{ recordLocation, prefix + baseDeclaration->getNameAsString(), "virtual base, located through a vbptr or the vtable" });
+            }
+            else if (depth < MAX_DEPTH)
+            {
+                CheckRecord(output, context, baseDeclaration, Helpers::FindBaseNode(node, baseDeclaration->getQualifiedNameAsString()), prefix, depth + 1);
+            }
+        }
+
+        const TNodes fieldNodes = Helpers::GetFieldNodes(node);
+        size_t fieldIndex = 0u;
+        for (const clang::FieldDecl* field : declaration->fields())
+        {
+            const Layout::Node* fieldNode = fieldIndex < fieldNodes.size() ? fieldNodes[fieldIndex] : nullptr;
+            ++fieldIndex;
+
+            const std::string path = prefix + field->getNameAsString();
+            const std::string location = fieldNode ? Report::GetLocationString(context.result, fieldNode->fieldLocation) : Report::GetLocationString(context.ast, field->getLocation());
+            const clang::QualType elementType = context.ast.getBaseElementType(field->getType());
+
+            if (const char* issue = Helpers::GetTypeIssue(context.ast, field->getType()))
+            {
+                output.push_back(Issue{ location, path, issue });
+            }
+            else if (const clang::CXXRecordDecl* record = elementType->getAsCXXRecordDecl())
+            {
+                if (record->isInStdNamespace() && !Report::IsStdType(elementType, "array"))
+                {
+                    output.push_back(Issue{ location, path, "std:: type, its representation is private to the standard library and may own heap memory" });
+                }
+                else if (Report::IsStdType(elementType, "array"))
+                {
+                    const clang::ClassTemplateSpecializationDecl* specialization = llvm::dyn_cast<clang::ClassTemplateSpecializationDecl>(record);
+                    const char* issue = specialization && specialization->getTemplateArgs().size() > 0 ? Helpers::GetTypeIssue(context.ast, specialization->getTemplateArgs().get(0).getAsType()) : nullptr;
+                    if (issue)
+                    {
+                        output.push_back(Issue{ location, path, issue });
+                    }
+                }
+                else if (depth < MAX_DEPTH)
+                {
+                    //arrays of records are simple fields in the layout tree, their own fields have no node
+                    CheckRecord(output, context, record, field->getType()->isArrayType() ? nullptr : fieldNode, path + '.', depth + 1);
+                }
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // 8 byte scalars are only 4 byte aligned inside records on i686 System V, offsets and size move with them
+    void CheckI686Layout(const Report::Context& context)
+    {
+        const llvm::Triple& triple = context.ast.getTargetInfo().getTriple();
+        if (triple.getArch() == llvm::Triple::x86 || triple.isOSWindows())
+        {
+            return;
+        }
+
+        Report::Shape shape;
+        Report::ComputeShape(shape, context.ast, context.declaration);
+
+        Report::Shape i686 = shape;
+        for (Report::Member& member : i686.members)
+        {
+            const clang::QualType elementType = context.ast.getBaseElementType(member.field->getType());
+            if (!member.field->isBitField() && (elementType->isIntegerType() || elementType->isRealFloatingType()) && member.align == 8 && context.ast.getTypeSizeInChars(elementType).getQuantity() == 8)
+            {
+                member.align = 4;
+            }
+        }
+        i686.minAlign = std::min<Layout::TAmount>(i686.minAlign, 4);
+
+        std::string moved;
+        Layout::TAmount offset  = shape.fieldsStart;
+        Layout::TAmount offset32 = i686.fieldsStart;
+        for (size_t i = 0; i < shape.members.size(); ++i)
+        {
+            offset   = Report::AlignTo(offset, shape.members[i].align);
+            offset32 = Report::AlignTo(offset32, i686.members[i].align);
+            if (offset != offset32)
+            {
+                moved += (moved.empty() ? "" : ", ") + shape.members[i].field->getNameAsString();
+            }
+            offset   += shape.members[i].size;
+            offset32 += i686.members[i].size;
+        }
+
+        const Layout::TAmount size   = Report::ComputeSize(shape);
+        const Layout::TAmount size32 = Report::ComputeSize(i686);
+        if (moved.empty() && size == size32)
+        {
+            context.out << "  i686 System V: same layout expected\n";
+            return;
+        }
+
+        context.out << "  i686 System V: 8 byte scalars are 4 byte aligned in records, size " << size << " -> " << size32;
+        if (!moved.empty())
+        {
+            context.out << ", fields moved: " << moved;
+        }
+        context.out << "\n    add explicit padding so every 8 byte field sits at an 8 byte aligned offset and the size is a multiple of 8\n";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Analyze(const Report::Context& context)
+    {
+        Report::WriteTitle(context, "Zero-copy readiness");
+
+        TIssues issues;
+
+        if (!context.declaration->isStandardLayout())
+        {
+            issues.push_back(Issue{ Report::GetLocationString(context.ast, context.declaration->getLocation()), context.declaration->getNameAsString(), "not standard layout, member offsets are not guaranteed" });
+        }
+
+        CheckRecord(issues, context, context.declaration, context.result.node, "", 0u);
+
+        //MSVC only packs adjacent bitfields into the same unit when their declared types have the same size, Itanium packs them regardless
+        std::string mixedBitfields;
+        const clang::FieldDecl* previous = nullptr;
+        for (const clang::FieldDecl* field : context.declaration->fields())
+        {
+            if (previous && previous->isBitField() && field->isBitField() && context.ast.getTypeSize(previous->getType()) != context.ast.getTypeSize(field->getType()))
+            {
+                mixedBitfields += (mixedBitfields.empty() ? "" : ", ") + previous->getNameAsString() + "/" + field->getNameAsString();
+            }
+            previous = field;
+        }
+
+        if (issues.empty())
+        {
+            context.out << "  Ready: no pointers, vptrs, std:: types or platform sized fields.\n";
+        }
+        else
+        {
+            context.out << "  NOT ready, " << issues.size() << " issues:\n";
+            for (const Issue& issue : issues)
+            {
+                context.out << "    " << issue.location << ": " << issue.path << ": " << issue.reason << "\n";
+            }
+        }
+
+        context.out << "  ABI differences:\n";
+        CheckI686Layout(context);
+        if (!mixedBitfields.empty())
+        {
+            context.out << "  bitfields: allocation differs between the MSVC and Itanium ABIs, adjacent bitfields have different type sizes: " << mixedBitfields << "\n";
+        }
+        context.out << "  Verify with a static_assert on sizeof and offsetof of every field.\n";
+    }
+}
@@ -0,0 +1,149 @@
+#include "CommandLine.h"
+
+#include <cstring>
+
+#include "IO.h"
+
+QueryParams::QueryParams()
+    : merge(nullptr)
+    , query(nullptr)
+    , sqlite(nullptr)
+    , cacheLineSize(64u)
+{}
+
+namespace CommandLine
+{ 
+    constexpr int FAILURE = -1;
+    constexpr int SUCCESS = 0;
+
+    namespace Utils
+    { 
+        // -----------------------------------------------------------------------------------------------------------
+        bool StringToUInt(unsigned int& output, const char* str)
+        { 
+            unsigned int ret = 0; 
+            while (char c = *str)
+            { 
+                if (c < '0' || c > '9') 
+                { 
+                    return false;
+                }
+
+                ret=ret*10+(c-'0'); 
+                ++str;
+            }
+
+            output = ret;
+            return true;
+        } 
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // -----------------------------------------------------------------------------------------------------------
+    void DisplayHelp()
+    {
+        QueryParams defaultParams;
+        LOG_ALWAYS("Struct Layout Database Query"); 
+        LOG_ALWAYS("");
+        LOG_ALWAYS("Loads project layout databases and lists the records matching a query."); 
+        LOG_ALWAYS("");
+        LOG_ALWAYS("Command Legend:"); 
+        
+        LOG_ALWAYS("-input          (-i)  : The path to a project layout database, repeatable to merge shard databases"); 
+        LOG_ALWAYS("-merge          (-m)  : Writes the merged databases, sorted so the same units give the same bytes however they were sharded"); 
+        LOG_ALWAYS("-query          (-q)  : The query to run, read from stdin one per line when not given"); 
+        LOG_ALWAYS("-sqlite         (-s)  : Export the records to a new SQLite database, no queries are read from stdin then"); 
+        LOG_ALWAYS("-cacheLine      (-cl) : The cache line size in bytes used for the 'cachelines' column (%u by default)", defaultParams.cacheLineSize); 
+        LOG_ALWAYS("-verbosity      (-v)  : Sets the verbosity level - example: '-v 1'"); 
+        LOG_ALWAYS("");
+        LOG_ALWAYS("Query Legend:"); 
+        LOG_ALWAYS("  <column> <op> <value> [and ...] [sort <column> [asc|desc]] [limit <count>]"); 
+        LOG_ALWAYS("  columns   : name, size, align, padding (waste), padding%%, cachelines, fields, category, file, line, units, layouts"); 
+        LOG_ALWAYS("  operators : < <= > >= = != and ~ for globs ('*' within a path segment, '**' across them)"); 
+        LOG_ALWAYS("  category  : plain, derived, polymorphic or virtual"); 
+        LOG_ALWAYS("  layouts   : above 1 when other units see a different layout under the same name (odr violation)"); 
+        LOG_ALWAYS("  example   : size > 256 and padding > 10%% and file ~ src/render/** sort waste limit 20"); 
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    int Parse(QueryParams& params, int argc, char* argv[])
+    { 
+        //No args
+        if (argc <= 1) 
+        {
+            LOG_ERROR("No arguments found. Type '?' for help.");
+            return FAILURE;
+        }
+
+        //Check for Help
+        for (int i=1;i<argc;++i)
+        { 
+            if (strcmp(argv[i],"?") == 0)
+            { 
+                DisplayHelp();
+                return FAILURE;
+            }
+        }
+
+        //Parse arguments
+        for(int i=1;i < argc;++i)
+        { 
+            char* argValue = argv[i];
+            if (argValue[0] == '-')
+            { 
+                if ((strcmp(argValue,"-i")==0 || strcmp(argValue,"-input")==0) && (i+1) < argc)
+                { 
+                    ++i;
+                    params.inputs.push_back(argv[i]);
+                }
+                else if ((strcmp(argValue,"-m")==0 || strcmp(argValue,"-merge")==0) && (i+1) < argc)
+                { 
+                    ++i;
+                    params.merge = argv[i];
+                }
+                else if ((strcmp(argValue,"-q")==0 || strcmp(argValue,"-query")==0) && (i+1) < argc)
+                { 
+                    ++i;
+                    params.query = argv[i];
+                }
+                else if ((strcmp(argValue,"-s")==0 || strcmp(argValue,"-sqlite")==0) && (i+1) < argc)
+                { 
+                    ++i;
+                    params.sqlite = argv[i];
+                }
+                else if ((strcmp(argValue,"-cl")==0 || strcmp(argValue,"-cacheLine")==0) && (i+1) < argc)
+                {
+                    ++i;
+                    unsigned int value = 0;
+                    if (Utils::StringToUInt(value,argv[i]) && value > 0)
+                    { 
+                        params.cacheLineSize = value;
+                    }
+                }
+                else if ((strcmp(argValue,"-v")==0 || strcmp(argValue,"-verbosity")==0) && (i+1) < argc)
+                {
+                    ++i;
+                    unsigned int value = 0;
+                    if (Utils::StringToUInt(value,argv[i]) && value < static_cast<unsigned int>(IO::Verbosity::Invalid))
+                    { 
+                        IO::SetVerbosityLevel(IO::Verbosity(value));
+                    }
+                } 
+            }
+            else
+            { 
+                //We assume that the free arguments are the input files
+                params.inputs.push_back(argValue);
+            }
+        }
+
+        if (params.inputs.empty())
+        {
+            LOG_ERROR("No input database given. Type '?' for help.");
+            return FAILURE;
+        }
+
+        return SUCCESS;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+struct QueryParams 
+{ 
+    QueryParams();
+
+    std::vector<const char*> inputs;        //several databases are merged into one
+    const char*              merge;         //where the merged database is written
+    const char*              query;         //queries are read from stdin one per line when none is given
+    const char*              sqlite;
+    unsigned int             cacheLineSize;
+};
+
+namespace CommandLine
+{ 
+    int Parse(QueryParams& args, int argc, char* argv[]);
+}
@@ -0,0 +1,177 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "IO.h"
+#include "LayoutDatabase.h"
+#include "LayoutIndex.h"
+#include "SQLiteExport.h"
+
+#include "CommandLine.h"
+
+constexpr int FAILURE = -1;
+constexpr int SUCCESS = 0;
+
+using TClock = std::chrono::steady_clock;
+
+// -----------------------------------------------------------------------------------------------------------
+long GetElapsedMiliseconds(const TClock::time_point start)
+{
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(TClock::now() - start).count());
+}
+
+// -----------------------------------------------------------------------------------------------------------
+void WriteRows(const LayoutIndex::Index& index, const LayoutIndex::TRows& rows)
+{
+    printf("%10s %6s %8s %6s %6s %6s %6s %7s  %-12s %s\n", "size", "align", "padding", "pad%", "lines", "fields", "units", "layouts", "category", "name (location)");
+    for (const unsigned int row : rows)
+    {
+        const int fileIndex = index.fileIndices[row];
+        const char* filename = fileIndex >= 0 ? index.files[fileIndex].c_str() : "<unknown>";
+
+        printf("%10lld %6lld %8lld %5.1f%% %6u %6u %6u %7u  %-12s %s (%s:%u)\n", index.sizes[row], index.aligns[row], index.paddings[row], index.paddingPercents[row], index.cacheLines[row], index.fields[row],
+            index.units[row], index.layouts[row], LayoutIndex::GetCategoryName(index.categories[row]), index.names[row].c_str(), filename, index.lines[row]);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+bool RunQuery(const LayoutIndex::Index& index, const std::string& text)
+{
+    LayoutIndex::Query query;
+    std::string error;
+    if (!LayoutIndex::Parse(query, error, text))
+    {
+        LOG_ERROR("%s", error.c_str());
+        return false;
+    }
+
+    const TClock::time_point start = TClock::now();
+    const LayoutIndex::TRows rows = LayoutIndex::Run(index, query);
+    const long elapsed = GetElapsedMiliseconds(start);
+
+    WriteRows(index, rows);
+    LOG_PROGRESS("%zu of %zu records", rows.size(), index.names.size());
+    IO::LogTime(IO::Verbosity::Info, "Query time: ", elapsed);
+    LOG_INFO("");
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+bool ExportSQLite(const LayoutDatabase::Database& database, const char* filename)
+{
+    const TClock::time_point start = TClock::now();
+
+    SQLiteExport::Writer writer;
+    if (!writer.Open(filename))
+    {
+        return false;
+    }
+
+    //all the records share the database files
+    Layout::Result result;
+    result.files = database.files;
+    for (const LayoutDatabase::Record& record : database.records)
+    {
+        result.node = record.node;
+        if (!writer.Add(result))
+        {
+            return false;
+        }
+    }
+
+    const bool ret = writer.Close();
+    IO::LogTime(IO::Verbosity::Info, "Export time: ", GetElapsedMiliseconds(start));
+    LOG_INFO("");
+    return ret;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+bool LoadDatabases(LayoutDatabase::Database& output, const std::vector<const char*>& filenames)
+{
+    for (size_t i = 0u; i < filenames.size(); ++i)
+    {
+        //the first database is the base the others are merged into
+        LayoutDatabase::Database database;
+        if (!LayoutDatabase::FromFile(i == 0u ? output : database, filenames[i]))
+        {
+            LOG_ERROR("Unable to read the layout database '%s'", filenames[i]);
+            LayoutDatabase::Clear(output);
+            return false;
+        }
+
+        if (i > 0u)
+        {
+            LayoutDatabase::Merge(output, database);
+        }
+    }
+
+    //the shard databases were sorted on their own, the merged one needs the same order as a single scan
+    if (filenames.size() > 1u)
+    {
+        LayoutDatabase::Canonicalize(output);
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    //Parse Command Line arguments
+    QueryParams params;
+    if (CommandLine::Parse(params, argc, argv) != 0)
+    {
+        return FAILURE;
+    }
+
+    //Load the databases and keep the columns only
+    const TClock::time_point start = TClock::now();
+    LayoutIndex::Index index;
+    {
+        LayoutDatabase::Database database;
+        if (!LoadDatabases(database, params.inputs))
+        {
+            return FAILURE;
+        }
+
+        if (params.merge && !LayoutDatabase::ToFile(database, params.merge))
+        {
+            LOG_ERROR("Unable to write the merged database '%s'", params.merge);
+            LayoutDatabase::Clear(database);
+            return FAILURE;
+        }
+
+        if (params.sqlite && !ExportSQLite(database, params.sqlite))
+        {
+            LayoutDatabase::Clear(database);
+            return FAILURE;
+        }
+
+        LayoutIndex::Build(index, database, params.cacheLineSize);
+        LayoutDatabase::Clear(database);
+    }
+    IO::LogTime(IO::Verbosity::Info, "Load time: ", GetElapsedMiliseconds(start));
+    LOG_INFO("");
+
+    if (params.query)
+    {
+        return RunQuery(index, params.query) ? SUCCESS : FAILURE;
+    }
+
+    if (params.sqlite || params.merge)
+    {
+        return SUCCESS;
+    }
+
+    //the index stays loaded so the following queries only pay for the filtering
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (!line.empty())
+        {
+            RunQuery(index, line);
+        }
+    }
+    return SUCCESS;
+}
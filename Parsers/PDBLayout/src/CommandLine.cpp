@@ -59,6 +59,7 @@ namespace CommandLine
         LOG_ALWAYS("-output         (-o)  : The output file path for the results ('%s' by default)",defaultParams.output); 
         LOG_ALWAYS("-locationFile   (-lf) : The source file path where the symbol is located.");
         LOG_ALWAYS("-locationRow    (-lr) : The source file line within the given 'locationFile' where the symbol is located.");
+        LOG_ALWAYS("-type           (-t)  : The qualified name of a type to extract, written as '<output>.<n>.slbin' (repeatable)");
         LOG_ALWAYS("-verbosity      (-v)  : Sets the verbosity level - example: '-v 1'"); 
     }
 
@@ -112,6 +113,11 @@ namespace CommandLine
                         params.locationLine = value;
                     }
                 }
+                else if ((Utils::StringCompare(argValue, L"-t") == 0 || Utils::StringCompare(argValue, L"-type") == 0) && (i + 1) < argc)
+                {
+                    ++i;
+                    params.typeNames.push_back(argv[i]);
+                }
                 else if ((Utils::StringCompare(argValue,L"-v")==0 || Utils::StringCompare(argValue,L"-verbosity")==0) && (i+1) < argc)
                 {
                     ++i;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 struct ExportParams 
 { 
     ExportParams();
@@ -8,6 +10,8 @@ struct ExportParams
     const wchar_t*  output;
     const wchar_t*  locationFile;
     unsigned int    locationLine; 
+
+    std::vector<const wchar_t*> typeNames;
 };
 
 namespace CommandLine
@@ -1,4 +1,8 @@
+#include "PDBReader.h"
+
 #include <algorithm>
+#include <string>
+#include <unordered_map>
 
 #include "IO.h"
 #include "LayoutDefinitions.h"
@@ -637,6 +641,56 @@ namespace PDBReader
         return nullptr;
     }
 
+    // -----------------------------------------------------------------------------------------------------------
+    using TNameIndex = std::unordered_map<std::wstring, IDiaSymbol*>;
+
+    void BuildNameIndex(TNameIndex& output, const SessionContext& context)
+    {
+        //a single pass over the UDTs, every query after that is a hash lookup
+        IDiaEnumSymbols* children = Helpers::FindChildren(context.globalScope, SymTagUDT);
+        while (IDiaSymbol* child = Helpers::Next(children, &IDiaEnumSymbols::Next))
+        {
+            const wchar_t* name = Helpers::QueryDIAFunction(child, &IDiaSymbol::get_name);
+            if (!name)
+            {
+                continue;
+            }
+
+            //keep the definition over the forward declarations
+            IDiaSymbol*& entry = output[name];
+            if (!entry || (Helpers::QueryDIAFunction(entry, &IDiaSymbol::get_length) == 0 && Helpers::QueryDIAFunction(child, &IDiaSymbol::get_length) > 0))
+            {
+                entry = child;
+            }
+        }
+
+        if (output.empty())
+        {
+            LOG_WARNING("There were no User Defined Types found in the input symbol database.");
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    IDiaSymbol* FindSymbolByName(const TNameIndex& index, const wchar_t* name)
+    {
+        //the pdb names are qualified from the global namespace without the leading '::'
+        for (; *name == L':'; ++name) {}
+
+        const TNameIndex::const_iterator found = index.find(name);
+        return found != index.end() ? found->second : nullptr;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    std::wstring GetQueryOutputPath(const wchar_t* outputPath, const size_t queryIndex)
+    {
+        //'result.slbin' becomes 'result.<n>.slbin'
+        std::wstring path = outputPath;
+        const size_t separator = path.find_last_of(L"/\\");
+        const size_t extension = path.find_last_of(L'.');
+        const size_t position  = extension != std::wstring::npos && (separator == std::wstring::npos || extension > separator) ? extension : path.size();
+        return path.insert(position, L"." + std::to_wstring(queryIndex));
+    }
+
     // -----------------------------------------------------------------------------------------------------------
     bool ExportResult(Layout::Result& result, const wchar_t* outputPath)
     {
@@ -646,7 +700,7 @@ namespace PDBReader
     }
 
     // -----------------------------------------------------------------------------------------------------------
-    bool ExportAtLocation(const wchar_t* pdbFile, const wchar_t* filename, const int line, const wchar_t* outputPath)
+    bool Export(const wchar_t* pdbFile, const wchar_t* filename, const int line, const TTypeNames& typeNames, const wchar_t* outputPath)
 	{
         if (!pdbFile)
         {
@@ -660,9 +714,9 @@ namespace PDBReader
             return false;
         }
 
-        if (!filename)
+        if (!filename && typeNames.empty())
         {
-            LOG_ERROR("No location file path provided.");
+            LOG_ERROR("No location file path or type name provided.");
             return false;
         }
 
@@ -673,10 +727,40 @@ namespace PDBReader
             return false;
         }
 
-        Layout::Result result;
-        IDiaSymbol* symbol = FindSymbolAtLocation(context, filename, line);
-        result.node = ComputeType(context, symbol);
+        bool ret = true;
+        if (filename)
+        {
+            Layout::Result result;
+            IDiaSymbol* symbol = FindSymbolAtLocation(context, filename, line);
+            result.node = ComputeType(context, symbol);
 
-        return ExportResult(result, outputPath);
+            ret = ExportResult(result, outputPath);
+        }
+
+        if (!typeNames.empty())
+        {
+            TNameIndex index;
+            BuildNameIndex(index, context);
+
+            for (size_t i = 0; i < typeNames.size(); ++i)
+            {
+                IDiaSymbol* symbol = FindSymbolByName(index, typeNames[i]);
+                if (!symbol)
+                {
+                    //the remaining names are still exported, the run fails so scripts notice the missing one
+                    LOG_ERROR("Unable to find the type '%ls'.", typeNames[i]);
+                    ret = false;
+                    continue;
+                }
+
+                Layout::Result result;
+                result.node = ComputeType(context, symbol);
+
+                const std::wstring queryOutputPath = GetQueryOutputPath(outputPath, i + 1);
+                ret = ExportResult(result, queryOutputPath.c_str()) && ret;
+            }
+        }
+
+        return ret;
 	}
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <vector>
+
 namespace PDBReader
 {
-	bool ExportAtLocation(const wchar_t* pdbFile, const wchar_t* filename, const int line, const wchar_t* output);
+	using TTypeNames = std::vector<const wchar_t*>;
+
+	bool Export(const wchar_t* pdbFile, const wchar_t* filename, const int line, const TTypeNames& typeNames, const wchar_t* output);
 }
\ No newline at end of file
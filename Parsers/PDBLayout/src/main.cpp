@@ -18,5 +18,5 @@ int wmain(int argc, wchar_t* argv[])
     }
 
     //Execute exporter
-    return PDBReader::ExportAtLocation(params.input, params.locationFile, params.locationLine, params.output) ? SUCCESS : FAILURE;
+    return PDBReader::Export(params.input, params.locationFile, params.locationLine, params.typeNames, params.output) ? SUCCESS : FAILURE;
 }
\ No newline at end of file
@@ -0,0 +1,694 @@
+#include "LayoutDatabase.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace LayoutDatabase
+{
+    //bump when the database format or the layout computation changes
+    enum { DATABASE_VERSION = 2 };
+    enum { MAX_STRING_LENGTH = 1 << 24 };
+
+    constexpr const char* DATABASE_HEADER = "StructLayoutDatabase";
+
+    //FNV-1a, the shared code stays free of llvm
+    constexpr uint64_t HASH_SEED  = 14695981039346656037ull;
+    constexpr uint64_t HASH_PRIME = 1099511628211ull;
+
+    using U8            = unsigned char;
+    using TRecordLookup = std::unordered_multimap<uint64_t, unsigned int>;
+
+    namespace Helpers
+    {
+        struct Reader
+        {
+            FILE* stream;
+            bool  isValid;
+        };
+
+        // -----------------------------------------------------------------------------------------------------------------
+        template<typename T> void Write(FILE* stream, const T input)
+        {
+            fwrite(&input, sizeof(T), 1, stream);
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        template<typename T> T Read(Reader& reader)
+        {
+            T output{};
+            reader.isValid = reader.isValid && fread(&output, sizeof(T), 1, reader.stream) == 1;
+            return output;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void WriteString(FILE* stream, const std::string& str)
+        {
+            //same 7bitSize encoding as the result files
+            size_t strSize = str.length();
+            do
+            {
+                const U8 val = strSize < 0x80 ? strSize & 0x7F : (strSize & 0x7F) | 0x80;
+                fwrite(&val, sizeof(U8), 1, stream);
+                strSize >>= 7;
+            }
+            while (strSize);
+
+            fwrite(str.c_str(), str.length(), 1, stream);
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        std::string ReadString(Reader& reader)
+        {
+            size_t strSize = 0u;
+            unsigned int shift = 0u;
+            U8 val = 0u;
+            do
+            {
+                val = Read<U8>(reader);
+                strSize |= static_cast<size_t>(val & 0x7F) << shift;
+                shift += 7u;
+            }
+            while (reader.isValid && (val & 0x80) && shift < 35u);
+
+            reader.isValid = reader.isValid && strSize <= MAX_STRING_LENGTH;
+            if (!reader.isValid || strSize == 0u)
+            {
+                return std::string();
+            }
+
+            std::string output(strSize, '\0');
+            reader.isValid = fread(&output[0], strSize, 1, reader.stream) == 1;
+            return output;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void WriteLocation(FILE* stream, const Layout::Location& location)
+        {
+            Write(stream, location.fileIndex);
+            Write(stream, location.line);
+            Write(stream, location.column);
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        Layout::Location ReadLocation(Reader& reader, const size_t numFiles)
+        {
+            Layout::Location location;
+            location.fileIndex = Read<int>(reader);
+            location.line      = Read<unsigned int>(reader);
+            location.column    = Read<unsigned int>(reader);
+
+            reader.isValid = reader.isValid && location.fileIndex >= Layout::INVALID_FILE_INDEX && location.fileIndex < static_cast<int>(numFiles);
+            return location;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void WriteNode(FILE* stream, const Layout::Node& node)
+        {
+            WriteString(stream, node.type);
+            WriteString(stream, node.name);
+            Write(stream, node.offset);
+            Write(stream, node.size);
+            Write(stream, node.align);
+            Write(stream, node.nature);
+
+            WriteLocation(stream, node.typeLocation);
+            WriteLocation(stream, node.fieldLocation);
+
+            Write(stream, static_cast<unsigned int>(node.children.size()));
+            for (const Layout::Node* child : node.children)
+            {
+                WriteNode(stream, *child);
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        Layout::Node* ReadNode(Reader& reader, const size_t numFiles)
+        {
+            Layout::Node* node = new Layout::Node();
+            node->type          = ReadString(reader);
+            node->name          = ReadString(reader);
+            node->offset        = Read<Layout::TAmount>(reader);
+            node->size          = Read<Layout::TAmount>(reader);
+            node->align         = Read<Layout::TAmount>(reader);
+            node->nature        = Read<Layout::Category>(reader);
+            node->typeLocation  = ReadLocation(reader, numFiles);
+            node->fieldLocation = ReadLocation(reader, numFiles);
+
+            const unsigned int numChildren = Read<unsigned int>(reader);
+            for (unsigned int i = 0u; i < numChildren && reader.isValid; ++i)
+            {
+                node->children.push_back(ReadNode(reader, numFiles));
+            }
+            return node;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void DestroyTree(Layout::Node* node)
+        {
+            if (node)
+            {
+                for (Layout::Node* child : node->children)
+                {
+                    DestroyTree(child);
+                }
+
+                delete node;
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        uint64_t HashBytes(uint64_t hash, const void* data, const size_t size)
+        {
+            const U8* bytes = static_cast<const U8*>(data);
+            for (size_t i = 0u; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * HASH_PRIME;
+            }
+            return hash;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        template<typename T> uint64_t HashValue(const uint64_t hash, const T value)
+        {
+            return HashBytes(hash, &value, sizeof(T));
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        uint64_t HashString(const uint64_t hash, const std::string& str)
+        {
+            //the length keeps "ab"+"c" apart from "a"+"bc"
+            return HashBytes(HashValue(hash, static_cast<uint64_t>(str.length())), str.c_str(), str.length());
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        uint64_t HashLayout(uint64_t hash, const Layout::Node& node)
+        {
+            //locations stay out, the same layout reached through different macros or headers hashes the same
+            hash = HashString(hash, node.type);
+            hash = HashString(hash, node.name);
+            hash = HashValue(hash, node.offset);
+            hash = HashValue(hash, node.size);
+            hash = HashValue(hash, node.align);
+            hash = HashValue(hash, node.nature);
+            hash = HashValue(hash, static_cast<unsigned int>(node.children.size()));
+
+            for (const Layout::Node* child : node.children)
+            {
+                hash = HashLayout(hash, *child);
+            }
+            return hash;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        uint64_t HashIdentity(const Record& record)
+        {
+            const Layout::Location& location = record.node->typeLocation;
+            uint64_t hash = HashString(HASH_SEED, record.node->type);
+            hash = HashValue(hash, location.fileIndex);
+            hash = HashValue(hash, location.line);
+            hash = HashValue(hash, location.column);
+            return HashValue(hash, record.layoutHash);
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        bool IsSameLayout(const Layout::Node& a, const Layout::Node& b)
+        {
+            if (a.type != b.type || a.name != b.name || a.offset != b.offset || a.size != b.size || a.align != b.align || a.nature != b.nature || a.children.size() != b.children.size())
+            {
+                return false;
+            }
+
+            for (size_t i = 0u; i < a.children.size(); ++i)
+            {
+                if (!IsSameLayout(*a.children[i], *b.children[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        bool IsSameRecord(const Record& a, const Record& b)
+        {
+            const Layout::Location& locationA = a.node->typeLocation;
+            const Layout::Location& locationB = b.node->typeLocation;
+            return a.layoutHash == b.layoutHash && locationA.fileIndex == locationB.fileIndex && locationA.line == locationB.line && locationA.column == locationB.column && IsSameLayout(*a.node, *b.node);
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void IndexRecords(Database& database)
+        {
+            database.recordIndices.clear();
+            database.recordIndices.reserve(database.records.size());
+            for (size_t i = 0u; i < database.records.size(); ++i)
+            {
+                database.recordIndices.emplace(HashIdentity(database.records[i]), static_cast<unsigned int>(i));
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void RemapLocation(Database& database, Layout::Location& location, const Layout::TFiles& files)
+        {
+            if (location.fileIndex == Layout::INVALID_FILE_INDEX)
+            {
+                return;
+            }
+
+            const std::string& filename = files[location.fileIndex];
+            const std::pair<std::unordered_map<std::string, int>::iterator, bool> found = database.fileIndices.emplace(filename, static_cast<int>(database.files.size()));
+            if (found.second)
+            {
+                database.files.push_back(filename);
+            }
+            location.fileIndex = found.first->second;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void RemapTree(Database& database, Layout::Node& node, const Layout::TFiles& files)
+        {
+            RemapLocation(database, node.typeLocation, files);
+            RemapLocation(database, node.fieldLocation, files);
+
+            for (Layout::Node* child : node.children)
+            {
+                RemapTree(database, *child, files);
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void InsertRecord(Database& database, Layout::Node* node, const Layout::TFiles& files, const TUnitIndices& units)
+        {
+            RemapTree(database, *node, files);
+
+            Record record;
+            record.node       = node;
+            record.units      = units;
+            record.layoutHash = HashLayout(HASH_SEED, *node);
+
+            //every unit including the definition sees the same record, keep the first one and gather the units
+            const uint64_t identity = HashIdentity(record);
+            const std::pair<TRecordLookup::iterator, TRecordLookup::iterator> range = database.recordIndices.equal_range(identity);
+            for (TRecordLookup::iterator it = range.first; it != range.second; ++it)
+            {
+                Record& existing = database.records[it->second];
+                if (IsSameRecord(existing, record))
+                {
+                    TUnitIndices merged;
+                    std::set_union(existing.units.begin(), existing.units.end(), units.begin(), units.end(), std::back_inserter(merged));
+                    existing.units = std::move(merged);
+
+                    DestroyTree(node);
+                    return;
+                }
+            }
+
+            database.recordIndices.emplace(identity, static_cast<unsigned int>(database.records.size()));
+            database.records.push_back(record);
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void MarkFiles(std::vector<bool>& isUsed, const Layout::Node& node)
+        {
+            for (const Layout::Location* location : { &node.typeLocation, &node.fieldLocation })
+            {
+                if (location->fileIndex != Layout::INVALID_FILE_INDEX)
+                {
+                    isUsed[location->fileIndex] = true;
+                }
+            }
+
+            for (const Layout::Node* child : node.children)
+            {
+                MarkFiles(isUsed, *child);
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        void ReindexFiles(Layout::Node& node, const std::vector<int>& remap)
+        {
+            for (Layout::Location* location : { &node.typeLocation, &node.fieldLocation })
+            {
+                if (location->fileIndex != Layout::INVALID_FILE_INDEX)
+                {
+                    location->fileIndex = remap[location->fileIndex];
+                }
+            }
+
+            for (Layout::Node* child : node.children)
+            {
+                ReindexFiles(*child, remap);
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------------
+        bool IsRecordLess(const Record& a, const Record& b)
+        {
+            //the files are sorted by then, their indices order the paths
+            const Layout::Location& locationA = a.node->typeLocation;
+            const Layout::Location& locationB = b.node->typeLocation;
+            const int order = a.node->type.compare(b.node->type);
+            if (order != 0)                                 return order < 0;
+            if (locationA.fileIndex != locationB.fileIndex) return locationA.fileIndex < locationB.fileIndex;
+            if (locationA.line != locationB.line)           return locationA.line < locationB.line;
+            if (locationA.column != locationB.column)       return locationA.column < locationB.column;
+            if (a.layoutHash != b.layoutHash)               return a.layoutHash < b.layoutHash;
+            return a.units < b.units;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    void Clear(Database& database)
+    {
+        for (Record& record : database.records)
+        {
+            Helpers::DestroyTree(record.node);
+        }
+
+        database.records.clear();
+        database.units.clear();
+        database.files.clear();
+        database.fileIndices.clear();
+        database.recordIndices.clear();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    bool ToFile(const Database& database, const char* filename)
+    {
+        FILE* stream;
+        const errno_t openResult = fopen_s(&stream, filename, "wb");
+        if (openResult)
+        {
+            return false;
+        }
+
+        Helpers::WriteString(stream, DATABASE_HEADER);
+        Helpers::Write(stream, static_cast<unsigned int>(DATABASE_VERSION));
+
+        Helpers::Write(stream, static_cast<unsigned int>(database.files.size()));
+        for (const std::string& file : database.files)
+        {
+            Helpers::WriteString(stream, file);
+        }
+
+        Helpers::Write(stream, static_cast<unsigned int>(database.units.size()));
+        for (const Unit& unit : database.units)
+        {
+            Helpers::WriteString(stream, unit.filename);
+            Helpers::Write(stream, unit.commandHash);
+
+            Helpers::Write(stream, static_cast<unsigned int>(unit.dependencies.size()));
+            for (const Dependency& dependency : unit.dependencies)
+            {
+                Helpers::WriteString(stream, dependency.filename);
+                Helpers::Write(stream, dependency.hash);
+            }
+        }
+
+        Helpers::Write(stream, static_cast<unsigned int>(database.records.size()));
+        for (const Record& record : database.records)
+        {
+            Helpers::Write(stream, static_cast<unsigned int>(record.units.size()));
+            for (const unsigned int unitIndex : record.units)
+            {
+                Helpers::Write(stream, unitIndex);
+            }
+
+            Helpers::WriteNode(stream, *record.node);
+        }
+
+        const bool ret = ferror(stream) == 0;
+        return fclose(stream) == 0 && ret;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    bool FromFile(Database& database, const char* filename)
+    {
+        Clear(database);
+
+        FILE* stream;
+        const errno_t openResult = fopen_s(&stream, filename, "rb");
+        if (openResult)
+        {
+            return false;
+        }
+
+        Helpers::Reader reader{ stream, true };
+        reader.isValid = Helpers::ReadString(reader) == DATABASE_HEADER && Helpers::Read<unsigned int>(reader) == DATABASE_VERSION;
+
+        const unsigned int numFiles = Helpers::Read<unsigned int>(reader);
+        for (unsigned int i = 0u; i < numFiles && reader.isValid; ++i)
+        {
+            database.files.push_back(Helpers::ReadString(reader));
+            database.fileIndices.emplace(database.files.back(), static_cast<int>(i));
+        }
+
+        const unsigned int numUnits = Helpers::Read<unsigned int>(reader);
+        for (unsigned int i = 0u; i < numUnits && reader.isValid; ++i)
+        {
+            Unit unit;
+            unit.filename    = Helpers::ReadString(reader);
+            unit.commandHash = Helpers::Read<uint64_t>(reader);
+
+            const unsigned int numDependencies = Helpers::Read<unsigned int>(reader);
+            for (unsigned int j = 0u; j < numDependencies && reader.isValid; ++j)
+            {
+                Dependency dependency;
+                dependency.filename = Helpers::ReadString(reader);
+                dependency.hash     = Helpers::Read<uint64_t>(reader);
+                unit.dependencies.push_back(dependency);
+            }
+
+            database.units.push_back(unit);
+        }
+
+        const unsigned int numRecords = Helpers::Read<unsigned int>(reader);
+        for (unsigned int i = 0u; i < numRecords && reader.isValid; ++i)
+        {
+            Record record;
+            const unsigned int numRecordUnits = Helpers::Read<unsigned int>(reader);
+            for (unsigned int j = 0u; j < numRecordUnits && reader.isValid; ++j)
+            {
+                record.units.push_back(Helpers::Read<unsigned int>(reader));
+                reader.isValid = reader.isValid && record.units.back() < database.units.size();
+            }
+
+            record.node       = Helpers::ReadNode(reader, database.files.size());
+            record.layoutHash = Helpers::HashLayout(HASH_SEED, *record.node);
+            database.records.push_back(record);
+        }
+
+        fclose(stream);
+
+        if (!reader.isValid)
+        {
+            Clear(database);
+            return false;
+        }
+
+        Helpers::IndexRecords(database);
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    void RemoveUnits(Database& database, const std::vector<bool>& isRemoved)
+    {
+        //new index of every unit kept
+        std::vector<unsigned int> remap(database.units.size(), 0u);
+        size_t numKept = 0u;
+        for (size_t i = 0u; i < database.units.size(); ++i)
+        {
+            if (!isRemoved[i])
+            {
+                remap[i] = static_cast<unsigned int>(numKept);
+                if (numKept != i)
+                {
+                    database.units[numKept] = std::move(database.units[i]);
+                }
+                ++numKept;
+            }
+        }
+        database.units.resize(numKept);
+
+        size_t numRecords = 0u;
+        for (size_t i = 0u; i < database.records.size(); ++i)
+        {
+            Record& record = database.records[i];
+            TUnitIndices units;
+            for (const unsigned int unitIndex : record.units)
+            {
+                if (!isRemoved[unitIndex])
+                {
+                    units.push_back(remap[unitIndex]);
+                }
+            }
+
+            if (units.empty())
+            {
+                Helpers::DestroyTree(record.node);
+                continue;
+            }
+
+            record.units = std::move(units);
+            if (numRecords != i)
+            {
+                database.records[numRecords] = std::move(record);
+            }
+            ++numRecords;
+        }
+        database.records.resize(numRecords);
+        Helpers::IndexRecords(database);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    unsigned int AddUnit(Database& database, const Unit& unit)
+    {
+        database.units.push_back(unit);
+        return static_cast<unsigned int>(database.units.size() - 1u);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    void AddRecord(Database& database, Layout::Node* node, const Layout::TFiles& files, const unsigned int unitIndex)
+    {
+        Helpers::InsertRecord(database, node, files, TUnitIndices{ unitIndex });
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    void Merge(Database& database, Database& other)
+    {
+        std::unordered_map<std::string, unsigned int> unitIndices;
+        for (size_t i = 0u; i < database.units.size(); ++i)
+        {
+            unitIndices.emplace(database.units[i].filename, static_cast<unsigned int>(i));
+        }
+
+        TUnitIndices unitRemap(other.units.size());
+        for (size_t i = 0u; i < other.units.size(); ++i)
+        {
+            const std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> found = unitIndices.emplace(other.units[i].filename, static_cast<unsigned int>(database.units.size()));
+            if (found.second)
+            {
+                database.units.push_back(std::move(other.units[i]));
+            }
+            unitRemap[i] = found.first->second;
+        }
+
+        for (Record& record : other.records)
+        {
+            TUnitIndices units;
+            for (const unsigned int unitIndex : record.units)
+            {
+                units.push_back(unitRemap[unitIndex]);
+            }
+            std::sort(units.begin(), units.end());
+            units.erase(std::unique(units.begin(), units.end()), units.end());
+
+            Helpers::InsertRecord(database, record.node, other.files, units);
+            record.node = nullptr;
+        }
+
+        Clear(other);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    void Canonicalize(Database& database)
+    {
+        //units by filename
+        TUnitIndices unitOrder(database.units.size());
+        std::iota(unitOrder.begin(), unitOrder.end(), 0u);
+        std::sort(unitOrder.begin(), unitOrder.end(), [&database](const unsigned int a, const unsigned int b) { return database.units[a].filename < database.units[b].filename; });
+
+        TUnitIndices unitRemap(database.units.size());
+        std::vector<Unit> units;
+        units.reserve(database.units.size());
+        for (size_t i = 0u; i < unitOrder.size(); ++i)
+        {
+            unitRemap[unitOrder[i]] = static_cast<unsigned int>(i);
+            units.push_back(std::move(database.units[unitOrder[i]]));
+        }
+        database.units = std::move(units);
+
+        //only the files still referenced, by path
+        std::vector<bool> isUsed(database.files.size(), false);
+        for (const Record& record : database.records)
+        {
+            Helpers::MarkFiles(isUsed, *record.node);
+        }
+
+        std::vector<int> fileOrder;
+        for (size_t i = 0u; i < isUsed.size(); ++i)
+        {
+            if (isUsed[i])
+            {
+                fileOrder.push_back(static_cast<int>(i));
+            }
+        }
+        std::sort(fileOrder.begin(), fileOrder.end(), [&database](const int a, const int b) { return database.files[a] < database.files[b]; });
+
+        std::vector<int> fileRemap(database.files.size(), Layout::INVALID_FILE_INDEX);
+        Layout::TFiles files;
+        files.reserve(fileOrder.size());
+        database.fileIndices.clear();
+        for (size_t i = 0u; i < fileOrder.size(); ++i)
+        {
+            fileRemap[fileOrder[i]] = static_cast<int>(i);
+            files.push_back(std::move(database.files[fileOrder[i]]));
+            database.fileIndices.emplace(files.back(), static_cast<int>(i));
+        }
+        database.files = std::move(files);
+
+        //records by name, definition and layout
+        for (Record& record : database.records)
+        {
+            Helpers::ReindexFiles(*record.node, fileRemap);
+            for (unsigned int& unitIndex : record.units)
+            {
+                unitIndex = unitRemap[unitIndex];
+            }
+            std::sort(record.units.begin(), record.units.end());
+        }
+        std::sort(database.records.begin(), database.records.end(), Helpers::IsRecordLess);
+
+        Helpers::IndexRecords(database);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    std::vector<TRecordIndices> FindLayoutMismatches(const Database& database)
+    {
+        TRecordIndices sorted(database.records.size());
+        for (size_t i = 0u; i < sorted.size(); ++i)
+        {
+            sorted[i] = static_cast<unsigned int>(i);
+        }
+
+        std::sort(sorted.begin(), sorted.end(), [&database](const unsigned int a, const unsigned int b)
+        {
+            const int order = database.records[a].node->type.compare(database.records[b].node->type);
+            return order < 0 || (order == 0 && a < b);
+        });
+
+        std::vector<TRecordIndices> output;
+        size_t first = 0u;
+        while (first < sorted.size())
+        {
+            const Record& reference = database.records[sorted[first]];
+            size_t last = first + 1u;
+            bool isMismatch = false;
+            for (; last < sorted.size() && database.records[sorted[last]].node->type == reference.node->type; ++last)
+            {
+                const Record& record = database.records[sorted[last]];
+                isMismatch = isMismatch || record.layoutHash != reference.layoutHash || !Helpers::IsSameLayout(*record.node, *reference.node);
+            }
+
+            //each unit has its own anonymous namespace, sharing the name is fine there
+            if (isMismatch && reference.node->type.find("(anonymous namespace)") == std::string::npos)
+            {
+                output.emplace_back(sorted.begin() + first, sorted.begin() + last);
+            }
+            first = last;
+        }
+        return output;
+    }
+}
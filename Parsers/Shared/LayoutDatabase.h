@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LayoutDefinitions.h"
+
+namespace LayoutDatabase
+{
+    // ----------------------------------------------------------------------------------------------------------
+    // A file a translation unit was parsed from and the hash of the contents the parse saw
+    struct Dependency
+    {
+        std::string filename;
+        uint64_t    hash;
+    };
+
+    using TDependencies  = std::vector<Dependency>;
+    using TUnitIndices   = std::vector<unsigned int>;
+    using TRecordIndices = std::vector<unsigned int>;
+
+    // ----------------------------------------------------------------------------------------------------------
+    struct Unit
+    {
+        Unit()
+            : commandHash(0u)
+        {}
+
+        std::string   filename;
+        uint64_t      commandHash;  //compile command the unit was parsed with
+        TDependencies dependencies; //main file and include closure
+    };
+
+    // ----------------------------------------------------------------------------------------------------------
+    struct Record
+    {
+        Record()
+            : node(nullptr)
+            , layoutHash(0u)
+        {}
+
+        Layout::Node* node;       //locations index the database files
+        TUnitIndices  units;      //sorted indices of the units the record was found in
+        uint64_t      layoutHash; //names, types, offsets, sizes and alignments of the whole tree, not serialized
+    };
+
+    // ----------------------------------------------------------------------------------------------------------
+    struct Database
+    {
+        Layout::TFiles                                  files;
+        std::vector<Unit>                               units;
+        std::vector<Record>                             records;
+        std::unordered_map<std::string, int>            fileIndices;   //lookup of the files, not serialized
+        std::unordered_multimap<uint64_t, unsigned int> recordIndices; //lookup of the records by name, definition and layout, not serialized
+    };
+
+    void Clear(Database& database);
+
+    bool ToFile(const Database& database, const char* filename);
+    bool FromFile(Database& database, const char* filename);
+
+    // Drops the flagged units along with the records only found in them, the remaining units keep their order
+    void RemoveUnits(Database& database, const std::vector<bool>& isRemoved);
+
+    unsigned int AddUnit(Database& database, const Unit& unit);
+
+    // Takes ownership of the node, its locations are remapped from the given files to the database ones
+    // A record with the same qualified name, definition location and layout is stored once, it only gains the unit
+    void AddRecord(Database& database, Layout::Node* node, const Layout::TFiles& files, const unsigned int unitIndex);
+
+    // Moves the units and records of the other database in, the units found in both keep the version already there
+    void Merge(Database& database, Database& other);
+
+    // Sorts the units, files and records and drops the unreferenced files, equal contents give byte identical files
+    void Canonicalize(Database& database);
+
+    // Groups of records sharing a qualified name but not a layout, ordered by name
+    // Those break the one definition rule, records in anonymous namespaces are left aside
+    std::vector<TRecordIndices> FindLayoutMismatches(const Database& database);
+}
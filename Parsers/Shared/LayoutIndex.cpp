@@ -0,0 +1,677 @@
+#include "LayoutIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <utility>
+
+#include "LayoutDatabase.h"
+
+namespace LayoutIndex
+{
+    using TIntervals = std::vector<std::pair<Layout::TAmount, Layout::TAmount>>;
+    using TTokens    = std::vector<std::string>;
+
+    struct ColumnName
+    {
+        const char* name;
+        Column      column;
+    };
+
+    //the first name of each column is the one displayed
+    constexpr ColumnName COLUMN_NAMES[] =
+    {
+        { "name",       Column::Name },
+        { "type",       Column::Name },
+        { "size",       Column::Size },
+        { "align",      Column::Align },
+        { "alignment",  Column::Align },
+        { "padding",    Column::Padding },
+        { "waste",      Column::Padding },
+        { "padding%",   Column::PaddingPercent },
+        { "waste%",     Column::PaddingPercent },
+        { "cachelines", Column::CacheLines },
+        { "fields",     Column::Fields },
+        { "category",   Column::Category },
+        { "kind",       Column::Category },
+        { "file",       Column::File },
+        { "path",       Column::File },
+        { "line",       Column::Line },
+        { "units",      Column::Units },
+        { "tus",        Column::Units },
+        { "layouts",    Column::Layouts },
+    };
+
+    constexpr const char* CATEGORY_NAMES[] = { "plain", "derived", "polymorphic", "virtual" };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        void CollectCoverage(TIntervals& output, const Layout::Node& node, const Layout::TAmount offset)
+        {
+            for (const Layout::Node* child : node.children)
+            {
+                //bitfields keep their bit range as a child, they cover their whole storage unit here
+                const Layout::TAmount childOffset = offset + child->offset;
+                if (child->nature == Layout::Category::Bitfield || child->children.empty())
+                {
+                    output.emplace_back(childOffset, childOffset + child->size);
+                }
+                else
+                {
+                    CollectCoverage(output, *child, childOffset);
+                }
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void CollectHoles(THoles& output, const Layout::Node& root, TIntervals& intervals)
+        {
+            intervals.clear();
+            CollectCoverage(intervals, root, 0);
+            std::sort(intervals.begin(), intervals.end());
+
+            Layout::TAmount end = 0;
+            for (const std::pair<Layout::TAmount, Layout::TAmount>& interval : intervals)
+            {
+                const Layout::TAmount begin = std::min(interval.first, root.size);
+                if (begin > end)
+                {
+                    output.push_back(Hole{ end, begin - end });
+                }
+                end = std::max(end, std::min(interval.second, root.size));
+            }
+
+            if (root.size > end)
+            {
+                output.push_back(Hole{ end, root.size - end });
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsPolymorphic(const Layout::Node& node)
+        {
+            for (const Layout::Node* child : node.children)
+            {
+                if (child->nature == Layout::Category::VTablePtr || child->nature == Layout::Category::VFTablePtr)
+                {
+                    return true;
+                }
+
+                if ((child->nature == Layout::Category::NVPrimaryBase || child->nature == Layout::Category::NVBase) && IsPolymorphic(*child))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        RecordCategory GetCategory(const Layout::Node& node)
+        {
+            bool hasBases = false;
+            for (const Layout::Node* child : node.children)
+            {
+                if (child->nature == Layout::Category::VPrimaryBase || child->nature == Layout::Category::VBase)
+                {
+                    return RecordCategory::VirtualBases;
+                }
+                hasBases = hasBases || child->nature == Layout::Category::NVPrimaryBase || child->nature == Layout::Category::NVBase;
+            }
+
+            return IsPolymorphic(node) ? RecordCategory::Polymorphic : hasBases ? RecordCategory::Derived : RecordCategory::Plain;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        unsigned int CountFields(const Layout::Node& node)
+        {
+            unsigned int count = 0u;
+            for (const Layout::Node* child : node.children)
+            {
+                count += child->nature == Layout::Category::SimpleField || child->nature == Layout::Category::Bitfield || child->nature == Layout::Category::ComplexField ? 1u : 0u;
+            }
+            return count;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        std::string ToLower(std::string text)
+        {
+            std::transform(text.begin(), text.end(), text.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return text;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsSameChar(const char a, const char b)
+        {
+            //paths are compared the same way on every platform
+            const char lowerA = a == '\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(a)));
+            const char lowerB = b == '\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(b)));
+            return lowerA == lowerB;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsSeparator(const char c)
+        {
+            return c == '/' || c == '\\';
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool MatchGlob(const char* pattern, const char* text)
+        {
+            while (*pattern)
+            {
+                if (pattern[0] == '*' && pattern[1] == '*')
+                {
+                    pattern += 2;
+
+                    //'**/' also matches no directory at all
+                    if (IsSeparator(*pattern) && MatchGlob(pattern + 1, text))
+                    {
+                        return true;
+                    }
+
+                    for (const char* it = text; ; ++it)
+                    {
+                        if (MatchGlob(pattern, it)) return true;
+                        if (!*it) return false;
+                    }
+                }
+
+                if (*pattern == '*')
+                {
+                    ++pattern;
+                    for (const char* it = text; ; ++it)
+                    {
+                        if (MatchGlob(pattern, it)) return true;
+                        if (!*it || IsSeparator(*it)) return false;
+                    }
+                }
+
+                if (!*text || (*pattern == '?' ? IsSeparator(*text) : !IsSameChar(*pattern, *text)))
+                {
+                    return false;
+                }
+
+                ++pattern;
+                ++text;
+            }
+            return *text == '\0';
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsRelativePattern(const std::string& pattern)
+        {
+            return !pattern.empty() && !IsSeparator(pattern[0]) && pattern[0] != '*' && (pattern.size() < 2 || pattern[1] != ':');
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsNumeric(const Column column)
+        {
+            return column != Column::Name && column != Column::File && column != Column::Category;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        Column FindColumn(const std::string& name)
+        {
+            const std::string lowerName = ToLower(name);
+            for (const ColumnName& entry : COLUMN_NAMES)
+            {
+                if (lowerName == entry.name)
+                {
+                    return entry.column;
+                }
+            }
+            return Column::Invalid;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        RecordCategory FindCategory(const std::string& name)
+        {
+            const std::string lowerName = ToLower(name);
+            for (size_t i = 0u; i < static_cast<size_t>(RecordCategory::Invalid); ++i)
+            {
+                if (lowerName == CATEGORY_NAMES[i])
+                {
+                    return static_cast<RecordCategory>(i);
+                }
+            }
+            return RecordCategory::Invalid;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool FindOperator(Operator& output, const std::string& text)
+        {
+            if      (text == "<")                  output = Operator::Less;
+            else if (text == "<=")                 output = Operator::LessEqual;
+            else if (text == ">")                  output = Operator::Greater;
+            else if (text == ">=")                 output = Operator::GreaterEqual;
+            else if (text == "=" || text == "==")  output = Operator::Equal;
+            else if (text == "!=" || text == "<>") output = Operator::NotEqual;
+            else if (text == "~")                  output = Operator::Match;
+            else return false;
+            return true;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsOperatorChar(const char c)
+        {
+            return c == '<' || c == '>' || c == '=' || c == '!' || c == '~';
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool Tokenize(TTokens& output, std::string& error, const std::string& text)
+        {
+            size_t i = 0u;
+            while (i < text.size())
+            {
+                if (std::isspace(static_cast<unsigned char>(text[i])))
+                {
+                    ++i;
+                }
+                else if (text[i] == '"' || text[i] == '\'')
+                {
+                    //quoted values keep their spaces and operator characters, template names need them
+                    const size_t end = text.find(text[i], i + 1);
+                    if (end == std::string::npos)
+                    {
+                        error = "Unterminated quoted value";
+                        return false;
+                    }
+                    output.push_back(text.substr(i + 1, end - i - 1));
+                    i = end + 1;
+                }
+                else
+                {
+                    const bool isOperator = IsOperatorChar(text[i]);
+                    const size_t begin = i;
+                    while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) && IsOperatorChar(text[i]) == isOperator && text[i] != '"' && text[i] != '\'')
+                    {
+                        ++i;
+                    }
+                    output.push_back(text.substr(begin, i - begin));
+                }
+            }
+            return true;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool ParseNumber(double& output, const std::string& text)
+        {
+            char* end = nullptr;
+            output = std::strtod(text.c_str(), &end);
+            return !text.empty() && end == text.c_str() + text.size();
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool ParsePredicate(Predicate& output, std::string& error, const TTokens& tokens, size_t& index)
+        {
+            if (index + 3u > tokens.size())
+            {
+                error = "Incomplete predicate after '" + tokens[index] + "', expected '<column> <operator> <value>'";
+                return false;
+            }
+
+            output.column = FindColumn(tokens[index]);
+            if (output.column == Column::Invalid)
+            {
+                error = "Unknown column '" + tokens[index] + "'";
+                return false;
+            }
+
+            if (!FindOperator(output.op, tokens[index + 1u]))
+            {
+                error = "Unknown operator '" + tokens[index + 1u] + "'";
+                return false;
+            }
+
+            std::string value = tokens[index + 2u];
+            index += 3u;
+
+            //'padding > 10%' reads as a percentage of the size
+            if (output.column == Column::Padding && value.size() > 1u && value.back() == '%')
+            {
+                output.column = Column::PaddingPercent;
+                value.pop_back();
+            }
+
+            if (IsNumeric(output.column))
+            {
+                if (output.op == Operator::Match || !ParseNumber(output.number, value))
+                {
+                    error = "Column '" + std::string(GetColumnName(output.column)) + "' expects a number compared with <, <=, >, >=, = or !=";
+                    return false;
+                }
+                return true;
+            }
+
+            if (output.column == Column::Category)
+            {
+                if ((output.op != Operator::Equal && output.op != Operator::NotEqual) || FindCategory(value) == RecordCategory::Invalid)
+                {
+                    error = "Column 'category' expects = or != with plain, derived, polymorphic or virtual";
+                    return false;
+                }
+                output.number = static_cast<double>(FindCategory(value));
+                return true;
+            }
+
+            if (output.op != Operator::Equal && output.op != Operator::NotEqual && output.op != Operator::Match)
+            {
+                error = "Column '" + std::string(GetColumnName(output.column)) + "' expects =, != or ~";
+                return false;
+            }
+
+            //relative file patterns match the end of the paths
+            output.text = output.column == Column::File && output.op == Operator::Match && IsRelativePattern(value) ? "**/" + value : value;
+            return true;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        template<typename TValue, typename TCompare> void KeepRows(TRows& rows, const std::vector<TValue>& values, const double number, const TCompare compare)
+        {
+            rows.erase(std::remove_if(rows.begin(), rows.end(), [&](const unsigned int row) { return !compare(static_cast<double>(values[row]), number); }), rows.end());
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        template<typename TValue> void FilterNumbers(TRows& rows, const std::vector<TValue>& values, const Predicate& predicate)
+        {
+            switch (predicate.op)
+            {
+            case Operator::Less:         KeepRows(rows, values, predicate.number, std::less<double>());          break;
+            case Operator::LessEqual:    KeepRows(rows, values, predicate.number, std::less_equal<double>());    break;
+            case Operator::Greater:      KeepRows(rows, values, predicate.number, std::greater<double>());       break;
+            case Operator::GreaterEqual: KeepRows(rows, values, predicate.number, std::greater_equal<double>()); break;
+            case Operator::Equal:        KeepRows(rows, values, predicate.number, std::equal_to<double>());      break;
+            case Operator::NotEqual:     KeepRows(rows, values, predicate.number, std::not_equal_to<double>());  break;
+            default: break;
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        bool MatchText(const std::string& value, const Predicate& predicate)
+        {
+            const bool isEqual = predicate.op == Operator::Match ? MatchGlob(predicate.text.c_str(), value.c_str()) : value == predicate.text;
+            return predicate.op == Operator::NotEqual ? !isEqual : isEqual;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void Filter(TRows& rows, const Index& index, const Predicate& predicate)
+        {
+            switch (predicate.column)
+            {
+            case Column::Size:           FilterNumbers(rows, index.sizes, predicate);           break;
+            case Column::Align:          FilterNumbers(rows, index.aligns, predicate);          break;
+            case Column::Padding:        FilterNumbers(rows, index.paddings, predicate);        break;
+            case Column::PaddingPercent: FilterNumbers(rows, index.paddingPercents, predicate); break;
+            case Column::CacheLines:     FilterNumbers(rows, index.cacheLines, predicate);      break;
+            case Column::Fields:         FilterNumbers(rows, index.fields, predicate);          break;
+            case Column::Line:           FilterNumbers(rows, index.lines, predicate);           break;
+            case Column::Units:          FilterNumbers(rows, index.units, predicate);           break;
+            case Column::Layouts:        FilterNumbers(rows, index.layouts, predicate);         break;
+            case Column::Category:
+            {
+                const RecordCategory category = static_cast<RecordCategory>(static_cast<int>(predicate.number));
+                const bool isEqual = predicate.op == Operator::Equal;
+                rows.erase(std::remove_if(rows.begin(), rows.end(), [&](const unsigned int row) { return (index.categories[row] == category) != isEqual; }), rows.end());
+                break;
+            }
+            case Column::Name:
+            {
+                rows.erase(std::remove_if(rows.begin(), rows.end(), [&](const unsigned int row) { return !MatchText(index.names[row], predicate); }), rows.end());
+                break;
+            }
+            case Column::File:
+            {
+                //there are far fewer files than records, match each one once
+                std::vector<bool> isFileMatch(index.files.size() + 1u, false);
+                isFileMatch[0] = MatchText(std::string(), predicate);
+                for (size_t i = 0u; i < index.files.size(); ++i)
+                {
+                    isFileMatch[i + 1u] = MatchText(index.files[i], predicate);
+                }
+                rows.erase(std::remove_if(rows.begin(), rows.end(), [&](const unsigned int row) { return !isFileMatch[index.fileIndices[row] + 1]; }), rows.end());
+                break;
+            }
+            default: break;
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        template<typename TLess> void SortRows(TRows& rows, const size_t limit, const TLess isLess)
+        {
+            //ties keep the database order so the output is stable
+            const auto compare = [&](const unsigned int a, const unsigned int b) { return isLess(a, b) || (!isLess(b, a) && a < b); };
+            if (limit > 0u && limit < rows.size())
+            {
+                std::partial_sort(rows.begin(), rows.begin() + limit, rows.end(), compare);
+                rows.resize(limit);
+            }
+            else
+            {
+                std::sort(rows.begin(), rows.end(), compare);
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        template<typename TValue> void SortByValues(TRows& rows, const std::vector<TValue>& values, const Query& query)
+        {
+            if (query.isDescending) SortRows(rows, query.limit, [&](const unsigned int a, const unsigned int b) { return values[b] < values[a]; });
+            else                    SortRows(rows, query.limit, [&](const unsigned int a, const unsigned int b) { return values[a] < values[b]; });
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void Sort(TRows& rows, const Index& index, const Query& query)
+        {
+            switch (query.sortColumn)
+            {
+            case Column::Name:           SortByValues(rows, index.names, query);           break;
+            case Column::Size:           SortByValues(rows, index.sizes, query);           break;
+            case Column::Align:          SortByValues(rows, index.aligns, query);          break;
+            case Column::Padding:        SortByValues(rows, index.paddings, query);        break;
+            case Column::PaddingPercent: SortByValues(rows, index.paddingPercents, query); break;
+            case Column::CacheLines:     SortByValues(rows, index.cacheLines, query);      break;
+            case Column::Fields:         SortByValues(rows, index.fields, query);          break;
+            case Column::Category:       SortByValues(rows, index.categories, query);      break;
+            case Column::Line:           SortByValues(rows, index.lines, query);           break;
+            case Column::Units:          SortByValues(rows, index.units, query);           break;
+            case Column::Layouts:        SortByValues(rows, index.layouts, query);         break;
+            case Column::File:
+            {
+                //by filename then line, rank the files once
+                std::vector<unsigned int> order(index.files.size());
+                std::iota(order.begin(), order.end(), 0u);
+                std::sort(order.begin(), order.end(), [&](const unsigned int a, const unsigned int b) { return index.files[a] < index.files[b]; });
+
+                std::vector<unsigned long long> keys(index.fileIndices.size());
+                std::vector<unsigned int> ranks(index.files.size() + 1u, 0u);
+                for (size_t i = 0u; i < order.size(); ++i)
+                {
+                    ranks[order[i] + 1u] = static_cast<unsigned int>(i + 1u);
+                }
+                for (const unsigned int row : rows)
+                {
+                    keys[row] = (static_cast<unsigned long long>(ranks[index.fileIndices[row] + 1]) << 32u) | index.lines[row];
+                }
+                SortByValues(rows, keys, query);
+                break;
+            }
+            default: break;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void CollectHoles(THoles& output, const Layout::Node& root)
+    {
+        TIntervals intervals;
+        Helpers::CollectHoles(output, root, intervals);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    void Build(Index& output, const LayoutDatabase::Database& database, const unsigned int cacheLineSize)
+    {
+        output = Index();
+        output.files = database.files;
+
+        const size_t numRecords = database.records.size();
+        output.names.reserve(numRecords);
+        output.sizes.reserve(numRecords);
+        output.aligns.reserve(numRecords);
+        output.paddings.reserve(numRecords);
+        output.paddingPercents.reserve(numRecords);
+        output.cacheLines.reserve(numRecords);
+        output.fields.reserve(numRecords);
+        output.categories.reserve(numRecords);
+        output.fileIndices.reserve(numRecords);
+        output.lines.reserve(numRecords);
+        output.units.reserve(numRecords);
+
+        const Layout::TAmount lineSize = std::max(1u, cacheLineSize);
+
+        TIntervals intervals;
+        THoles holes;
+        for (const LayoutDatabase::Record& record : database.records)
+        {
+            const Layout::Node& node = *record.node;
+
+            holes.clear();
+            Helpers::CollectHoles(holes, node, intervals);
+
+            Layout::TAmount padding = 0;
+            for (const Hole& hole : holes)
+            {
+                padding += hole.size;
+            }
+
+            output.names.push_back(node.type);
+            output.sizes.push_back(node.size);
+            output.aligns.push_back(node.align);
+            output.paddings.push_back(padding);
+            output.paddingPercents.push_back(node.size > 0 ? 100.0f * static_cast<float>(padding) / static_cast<float>(node.size) : 0.0f);
+            output.cacheLines.push_back(static_cast<unsigned int>((node.size + lineSize - 1) / lineSize));
+            output.fields.push_back(Helpers::CountFields(node));
+            output.categories.push_back(Helpers::GetCategory(node));
+            output.fileIndices.push_back(node.typeLocation.fileIndex);
+            output.lines.push_back(node.typeLocation.line);
+            output.units.push_back(static_cast<unsigned int>(record.units.size()));
+        }
+
+        //every record of a mismatching name gets the number of layouts found for it
+        output.layouts.assign(numRecords, 1u);
+        std::vector<uint64_t> hashes;
+        for (const LayoutDatabase::TRecordIndices& mismatch : LayoutDatabase::FindLayoutMismatches(database))
+        {
+            hashes.clear();
+            for (const unsigned int recordIndex : mismatch)
+            {
+                hashes.push_back(database.records[recordIndex].layoutHash);
+            }
+            std::sort(hashes.begin(), hashes.end());
+
+            const unsigned int numLayouts = static_cast<unsigned int>(std::unique(hashes.begin(), hashes.end()) - hashes.begin());
+            for (const unsigned int recordIndex : mismatch)
+            {
+                output.layouts[recordIndex] = numLayouts;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Parse(Query& output, std::string& error, const std::string& text)
+    {
+        output = Query();
+
+        TTokens tokens;
+        if (!Helpers::Tokenize(tokens, error, text))
+        {
+            return false;
+        }
+
+        size_t index = 0u;
+        while (index < tokens.size())
+        {
+            const std::string keyword = Helpers::ToLower(tokens[index]);
+            if (keyword == "and" || keyword == "where")
+            {
+                ++index;
+            }
+            else if (keyword == "sort" || keyword == "order")
+            {
+                index += index + 1u < tokens.size() && Helpers::ToLower(tokens[index + 1u]) == "by" ? 2u : 1u;
+                output.sortColumn = index < tokens.size() ? Helpers::FindColumn(tokens[index]) : Column::Invalid;
+                if (output.sortColumn == Column::Invalid)
+                {
+                    error = "Expected a column to sort by";
+                    return false;
+                }
+                ++index;
+
+                //numbers sort from the largest and text from the smallest unless told otherwise
+                output.isDescending = Helpers::IsNumeric(output.sortColumn);
+                const std::string direction = index < tokens.size() ? Helpers::ToLower(tokens[index]) : std::string();
+                if (direction == "asc" || direction == "desc")
+                {
+                    output.isDescending = direction == "desc";
+                    ++index;
+                }
+            }
+            else if (keyword == "limit")
+            {
+                double limit = 0.0;
+                if (index + 1u >= tokens.size() || !Helpers::ParseNumber(limit, tokens[index + 1u]) || limit < 0.0)
+                {
+                    error = "Expected a row count after 'limit'";
+                    return false;
+                }
+                output.limit = static_cast<size_t>(limit);
+                index += 2u;
+            }
+            else
+            {
+                Predicate predicate;
+                if (!Helpers::ParsePredicate(predicate, error, tokens, index))
+                {
+                    return false;
+                }
+                output.predicates.push_back(predicate);
+            }
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    TRows Run(const Index& index, const Query& query)
+    {
+        TRows rows(index.names.size());
+        std::iota(rows.begin(), rows.end(), 0u);
+
+        for (const Predicate& predicate : query.predicates)
+        {
+            Helpers::Filter(rows, index, predicate);
+        }
+
+        Helpers::Sort(rows, index, query);
+        return rows;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    const char* GetColumnName(const Column column)
+    {
+        for (const ColumnName& entry : COLUMN_NAMES)
+        {
+            if (entry.column == column)
+            {
+                return entry.name;
+            }
+        }
+        return "<invalid>";
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    const char* GetCategoryName(const RecordCategory category)
+    {
+        return category < RecordCategory::Invalid ? CATEGORY_NAMES[static_cast<size_t>(category)] : "<invalid>";
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "LayoutDefinitions.h"
+
+namespace LayoutDatabase
+{
+    struct Database;
+}
+
+namespace LayoutIndex
+{
+    // ----------------------------------------------------------------------------------------------------------
+    enum class RecordCategory : unsigned char
+    {
+        Plain = 0,
+        Derived,      //non virtual bases only
+        Polymorphic,  //own or inherited vtable pointer
+        VirtualBases,
+
+        Invalid
+    };
+
+    // ----------------------------------------------------------------------------------------------------------
+    enum class Column : unsigned char
+    {
+        Name = 0,
+        Size,
+        Align,
+        Padding,        //bytes of the flattened layout not covered by any field, base or table pointer
+        PaddingPercent,
+        CacheLines,
+        Fields,
+        Category,
+        File,
+        Line,
+        Units,          //translation units the record was found in
+        Layouts,        //distinct layouts sharing the qualified name, more than one is an odr violation
+
+        Invalid
+    };
+
+    // ----------------------------------------------------------------------------------------------------------
+    // Column oriented view of the records of a database, row i describes record i
+    struct Index
+    {
+        std::vector<std::string>     names;
+        std::vector<Layout::TAmount> sizes;
+        std::vector<Layout::TAmount> aligns;
+        std::vector<Layout::TAmount> paddings;
+        std::vector<float>           paddingPercents;
+        std::vector<unsigned int>    cacheLines;
+        std::vector<unsigned int>    fields;
+        std::vector<RecordCategory>  categories;
+        std::vector<int>             fileIndices;
+        std::vector<unsigned int>    lines;
+        std::vector<unsigned int>    units;
+        std::vector<unsigned int>    layouts;
+        Layout::TFiles               files;
+    };
+
+    // ----------------------------------------------------------------------------------------------------------
+    enum class Operator : unsigned char
+    {
+        Less = 0,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        Match,      //glob: '*' and '?' stay within a path segment, '**' crosses them
+    };
+
+    struct Predicate
+    {
+        Column      column;
+        Operator    op;
+        double      number;
+        std::string text;
+    };
+
+    struct Query
+    {
+        Query()
+            : sortColumn(Column::Padding)
+            , isDescending(true)
+            , limit(0u)
+        {}
+
+        std::vector<Predicate> predicates; //all of them must hold
+        Column                 sortColumn;
+        bool                   isDescending;
+        size_t                 limit;      //0 for all the matches
+    };
+
+    // ----------------------------------------------------------------------------------------------------------
+    struct Hole
+    {
+        Layout::TAmount offset;
+        Layout::TAmount size;
+    };
+
+    using THoles = std::vector<Hole>;
+    using TRows  = std::vector<unsigned int>;
+
+    // Appends the gaps of the flattened layout not covered by any field, base or table pointer, sorted by offset
+    void CollectHoles(THoles& output, const Layout::Node& root);
+
+    void Build(Index& output, const LayoutDatabase::Database& database, const unsigned int cacheLineSize);
+
+    // Parses queries like "size > 256 and padding > 10% and file ~ src/render/** sort waste desc limit 50"
+    bool Parse(Query& output, std::string& error, const std::string& text);
+
+    // Returns the rows matching every predicate in the query order
+    TRows Run(const Index& index, const Query& query);
+
+    const char* GetColumnName(const Column column);
+    const char* GetCategoryName(const RecordCategory category);
+}
@@ -0,0 +1,341 @@
+#include "SQLiteExport.h"
+
+#include <cstdio>
+#include <functional>
+
+#include <sqlite3.h>
+
+#include "IO.h"
+#include "LayoutIndex.h"
+
+namespace SQLiteExport
+{
+    //rows per transaction, large enough to amortize the commits while keeping the journal small
+    enum { BATCH_ROWS = 1 << 17 };
+
+    //the file is always written from scratch, a failed export is simply done again
+    constexpr const char* SCHEMA = R"(
+        PRAGMA journal_mode = OFF;
+        PRAGMA synchronous = OFF;
+        PRAGMA locking_mode = EXCLUSIVE;
+        PRAGMA cache_size = -131072;
+
+        CREATE TABLE files     (id INTEGER PRIMARY KEY, path TEXT NOT NULL UNIQUE);
+        CREATE TABLE locations (id INTEGER PRIMARY KEY, file_id INTEGER NOT NULL REFERENCES files(id), line INTEGER NOT NULL, col INTEGER NOT NULL);
+        CREATE TABLE types     (id INTEGER PRIMARY KEY, name TEXT NOT NULL, size INTEGER NOT NULL, align INTEGER NOT NULL, location_id INTEGER REFERENCES locations(id));
+        CREATE TABLE bases     (id INTEGER PRIMARY KEY, type_id INTEGER NOT NULL REFERENCES types(id), parent_id INTEGER, name TEXT NOT NULL, is_virtual INTEGER NOT NULL, is_primary INTEGER NOT NULL,
+                                byte_offset INTEGER NOT NULL, size INTEGER NOT NULL, align INTEGER NOT NULL, location_id INTEGER REFERENCES locations(id));
+        CREATE TABLE fields    (id INTEGER PRIMARY KEY, type_id INTEGER NOT NULL REFERENCES types(id), parent_id INTEGER, name TEXT, type_name TEXT, kind TEXT NOT NULL,
+                                byte_offset INTEGER NOT NULL, size INTEGER NOT NULL, align INTEGER NOT NULL, bit_offset INTEGER, bit_size INTEGER, location_id INTEGER REFERENCES locations(id));
+        CREATE TABLE holes     (id INTEGER PRIMARY KEY, type_id INTEGER NOT NULL REFERENCES types(id), byte_offset INTEGER NOT NULL, size INTEGER NOT NULL);
+
+        BEGIN;
+    )";
+
+    //created once the rows are in, cheaper than updating them on every insert
+    constexpr const char* INDICES = R"(
+        CREATE INDEX types_name ON types(name);
+        CREATE INDEX bases_type ON bases(type_id);
+        CREATE INDEX fields_type ON fields(type_id);
+        CREATE INDEX holes_type ON holes(type_id);
+    )";
+
+    constexpr const char* STATEMENTS[] =
+    {
+        "INSERT INTO files (id, path) VALUES (?1, ?2)",
+        "INSERT INTO locations (id, file_id, line, col) VALUES (?1, ?2, ?3, ?4)",
+        "INSERT INTO types (id, name, size, align, location_id) VALUES (?1, ?2, ?3, ?4, ?5)",
+        "INSERT INTO bases (id, type_id, parent_id, name, is_virtual, is_primary, byte_offset, size, align, location_id) VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)",
+        "INSERT INTO fields (id, type_id, parent_id, name, type_name, kind, byte_offset, size, align, bit_offset, bit_size, location_id) VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12)",
+        "INSERT INTO holes (type_id, byte_offset, size) VALUES (?1, ?2, ?3)",
+    };
+
+    namespace Helpers
+    {
+        // -----------------------------------------------------------------------------------------------------------
+        bool IsBase(const Layout::Category category)
+        {
+            return category == Layout::Category::VPrimaryBase || category == Layout::Category::VBase || category == Layout::Category::NVPrimaryBase || category == Layout::Category::NVBase;
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        const char* GetFieldKind(const Layout::Category category)
+        {
+            switch (category)
+            {
+            case Layout::Category::SimpleField:  return "field";
+            case Layout::Category::Bitfield:     return "bitfield";
+            case Layout::Category::ComplexField: return "record";
+            case Layout::Category::VTablePtr:    return "vptr";
+            case Layout::Category::VFTablePtr:   return "vfptr";
+            case Layout::Category::VBTablePtr:   return "vbptr";
+            case Layout::Category::VtorDisp:     return "vtordisp";
+            default:                             return "unknown";
+            }
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void BindText(sqlite3_stmt* statement, const int index, const std::string& text)
+        {
+            //every row is stepped before its strings go away, no copies needed
+            sqlite3_bind_text(statement, index, text.c_str(), static_cast<int>(text.size()), SQLITE_STATIC);
+        }
+
+        // -----------------------------------------------------------------------------------------------------------
+        void BindId(sqlite3_stmt* statement, const int index, const long long id)
+        {
+            if (id > 0) sqlite3_bind_int64(statement, index, id);
+            else        sqlite3_bind_null(statement, index);
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    size_t Writer::LocationKeyHash::operator()(const LocationKey& key) const
+    {
+        return std::hash<long long>()(key.fileId) ^ (std::hash<unsigned int>()(key.line) * 31u) ^ (std::hash<unsigned int>()(key.column) * 131071u);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    Writer::Writer()
+        : m_database(nullptr)
+        , m_statements{}
+        , m_nextNodeId(1)
+        , m_pendingRows(0u)
+    {}
+
+    // -----------------------------------------------------------------------------------------------------------
+    Writer::~Writer()
+    {
+        Close();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Writer::Open(const char* filename)
+    {
+        Close();
+        std::remove(filename);
+
+        if (sqlite3_open_v2(filename, &m_database, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK)
+        {
+            LOG_ERROR("Unable to create the SQLite database '%s': %s", filename, m_database ? sqlite3_errmsg(m_database) : "out of memory");
+            Close();
+            return false;
+        }
+
+        if (!Execute(SCHEMA))
+        {
+            Close();
+            return false;
+        }
+
+        for (int i = 0; i < NumStatements; ++i)
+        {
+            if (sqlite3_prepare_v2(m_database, STATEMENTS[i], -1, &m_statements[i], nullptr) != SQLITE_OK)
+            {
+                LOG_ERROR("Unable to prepare the SQLite statement '%s': %s", STATEMENTS[i], sqlite3_errmsg(m_database));
+                Close();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Writer::Add(const Layout::Result& result)
+    {
+        if (!m_database || !result.node)
+        {
+            return false;
+        }
+
+        const Layout::Node& root = *result.node;
+        const long long typeId = m_nextNodeId++;
+
+        sqlite3_stmt* statement = m_statements[InsertType];
+        sqlite3_bind_int64(statement, 1, typeId);
+        Helpers::BindText(statement, 2, root.type);
+        sqlite3_bind_int64(statement, 3, root.size);
+        sqlite3_bind_int64(statement, 4, root.align);
+        Helpers::BindId(statement, 5, GetLocationId(result, root.typeLocation));
+        if (!Step(InsertType) || !AddChildren(result, root, typeId, 0, 0))
+        {
+            return false;
+        }
+
+        LayoutIndex::THoles holes;
+        LayoutIndex::CollectHoles(holes, root);
+        for (const LayoutIndex::Hole& hole : holes)
+        {
+            statement = m_statements[InsertHole];
+            sqlite3_bind_int64(statement, 1, typeId);
+            sqlite3_bind_int64(statement, 2, hole.offset);
+            sqlite3_bind_int64(statement, 3, hole.size);
+            if (!Step(InsertHole))
+            {
+                return false;
+            }
+        }
+
+        //commit in batches
+        if (m_pendingRows >= BATCH_ROWS)
+        {
+            m_pendingRows = 0u;
+            return Execute("COMMIT; BEGIN;");
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Writer::Close()
+    {
+        bool ret = true;
+        if (m_database)
+        {
+            ret = Execute("COMMIT;") && Execute(INDICES);
+        }
+
+        for (sqlite3_stmt*& statement : m_statements)
+        {
+            sqlite3_finalize(statement);
+            statement = nullptr;
+        }
+
+        if (m_database)
+        {
+            sqlite3_close(m_database);
+            m_database = nullptr;
+        }
+
+        m_fileIds.clear();
+        m_locationIds.clear();
+        m_nextNodeId  = 1;
+        m_pendingRows = 0u;
+        return ret;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Writer::Execute(const char* sql)
+    {
+        char* error = nullptr;
+        if (sqlite3_exec(m_database, sql, nullptr, nullptr, &error) != SQLITE_OK)
+        {
+            LOG_ERROR("SQLite export failed: %s", error ? error : "unknown error");
+            sqlite3_free(error);
+            return false;
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Writer::Step(const Statement statement)
+    {
+        const int stepResult = sqlite3_step(m_statements[statement]);
+        sqlite3_reset(m_statements[statement]);
+        sqlite3_clear_bindings(m_statements[statement]);
+
+        if (stepResult != SQLITE_DONE)
+        {
+            LOG_ERROR("SQLite export failed: %s", sqlite3_errmsg(m_database));
+            return false;
+        }
+
+        ++m_pendingRows;
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    long long Writer::GetLocationId(const Layout::Result& result, const Layout::Location& location)
+    {
+        if (location.fileIndex < 0 || location.fileIndex >= static_cast<int>(result.files.size()))
+        {
+            return 0;
+        }
+
+        //files and locations are shared by every result added
+        const std::string& filename = result.files[location.fileIndex];
+        const std::pair<TFileIds::iterator, bool> file = m_fileIds.emplace(filename, static_cast<long long>(m_fileIds.size() + 1u));
+        if (file.second)
+        {
+            sqlite3_stmt* statement = m_statements[InsertFile];
+            sqlite3_bind_int64(statement, 1, file.first->second);
+            Helpers::BindText(statement, 2, filename);
+            Step(InsertFile);
+        }
+
+        const std::pair<TLocationIds::iterator, bool> found = m_locationIds.emplace(LocationKey{ file.first->second, location.line, location.column }, static_cast<long long>(m_locationIds.size() + 1u));
+        if (found.second)
+        {
+            sqlite3_stmt* statement = m_statements[InsertLocation];
+            sqlite3_bind_int64(statement, 1, found.first->second);
+            sqlite3_bind_int64(statement, 2, file.first->second);
+            sqlite3_bind_int64(statement, 3, location.line);
+            sqlite3_bind_int64(statement, 4, location.column);
+            Step(InsertLocation);
+        }
+        return found.first->second;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    bool Writer::AddChildren(const Layout::Result& result, const Layout::Node& node, const long long typeId, const long long parentId, const Layout::TAmount offset)
+    {
+        for (const Layout::Node* child : node.children)
+        {
+            //offsets are stored from the start of the type
+            const Layout::Node& current = *child;
+            const Layout::TAmount currentOffset = offset + current.offset;
+            const long long id = m_nextNodeId++;
+
+            if (Helpers::IsBase(current.nature))
+            {
+                sqlite3_stmt* statement = m_statements[InsertBase];
+                sqlite3_bind_int64(statement, 1, id);
+                sqlite3_bind_int64(statement, 2, typeId);
+                Helpers::BindId(statement, 3, parentId);
+                Helpers::BindText(statement, 4, current.type);
+                sqlite3_bind_int(statement, 5, current.nature == Layout::Category::VPrimaryBase || current.nature == Layout::Category::VBase ? 1 : 0);
+                sqlite3_bind_int(statement, 6, current.nature == Layout::Category::VPrimaryBase || current.nature == Layout::Category::NVPrimaryBase ? 1 : 0);
+                sqlite3_bind_int64(statement, 7, currentOffset);
+                sqlite3_bind_int64(statement, 8, current.size);
+                sqlite3_bind_int64(statement, 9, current.align);
+                Helpers::BindId(statement, 10, GetLocationId(result, current.typeLocation));
+                if (!Step(InsertBase) || !AddChildren(result, current, typeId, id, currentOffset))
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            sqlite3_stmt* statement = m_statements[InsertField];
+            sqlite3_bind_int64(statement, 1, id);
+            sqlite3_bind_int64(statement, 2, typeId);
+            Helpers::BindId(statement, 3, parentId);
+            Helpers::BindText(statement, 4, current.name);
+            Helpers::BindText(statement, 5, current.type);
+            sqlite3_bind_text(statement, 6, Helpers::GetFieldKind(current.nature), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(statement, 7, currentOffset);
+            sqlite3_bind_int64(statement, 8, current.size);
+            sqlite3_bind_int64(statement, 9, current.align);
+
+            //bitfields keep their bit range in their only child
+            const bool isBitfield = current.nature == Layout::Category::Bitfield && !current.children.empty();
+            if (isBitfield)
+            {
+                sqlite3_bind_int64(statement, 10, current.children[0]->offset);
+                sqlite3_bind_int64(statement, 11, current.children[0]->size);
+            }
+            Helpers::BindId(statement, 12, GetLocationId(result, current.fieldLocation));
+
+            if (!Step(InsertField))
+            {
+                return false;
+            }
+
+            if (!isBitfield && !AddChildren(result, current, typeId, id, currentOffset))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LayoutDefinitions.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace SQLiteExport
+{
+    // Writes layout trees into a new SQLite database, each root becomes a type with its bases, fields and holes
+    class Writer
+    {
+    public:
+        Writer();
+        ~Writer();
+
+        // Replaces any existing file
+        bool Open(const char* filename);
+        bool Add(const Layout::Result& result);
+        bool Close();
+
+    private:
+        enum Statement
+        {
+            InsertFile = 0,
+            InsertLocation,
+            InsertType,
+            InsertBase,
+            InsertField,
+            InsertHole,
+
+            NumStatements
+        };
+
+        struct LocationKey
+        {
+            long long    fileId;
+            unsigned int line;
+            unsigned int column;
+
+            bool operator==(const LocationKey& other) const { return fileId == other.fileId && line == other.line && column == other.column; }
+        };
+
+        struct LocationKeyHash
+        {
+            size_t operator()(const LocationKey& key) const;
+        };
+
+        using TFileIds     = std::unordered_map<std::string, long long>;
+        using TLocationIds = std::unordered_map<LocationKey, long long, LocationKeyHash>;
+
+        bool Execute(const char* sql);
+        bool Step(const Statement statement);
+        long long GetLocationId(const Layout::Result& result, const Layout::Location& location);
+        bool AddChildren(const Layout::Result& result, const Layout::Node& node, const long long typeId, const long long parentId, const Layout::TAmount offset);
+
+    private:
+        sqlite3*      m_database;
+        sqlite3_stmt* m_statements[NumStatements];
+        TFileIds      m_fileIds;
+        TLocationIds  m_locationIds;
+        long long     m_nextNodeId;   //bases and fields share the ids so parent_id can point to either
+        size_t        m_pendingRows;
+    };
+}